@@ -0,0 +1,67 @@
+#!/bin/sh
+# Kills random hangman-bench bots with SIGKILL while they play, at any point of the
+# protocol, and checks that the server keeps serving: the request counter has to grow
+# every second, a second benchmark has to claim all 64 slots without errors and no
+# session of a killed bot may be left over.
+#
+# Usage: bench/chaos.sh [seconds] [clients] [word-list] [server-flags...]
+
+DURATION=${1:-10}
+CLIENTS=${2:-32}
+WORDS=${3:-words.txt}
+[ $# -ge 3 ] && shift 3 || shift $#
+
+stat() {
+    ./hangman-stats | tr ' ' '\n' | sed -n "s/^$1=//p"
+}
+
+./hangman-server -v 0 "$@" "$WORDS" > /dev/null &
+server=$!
+sleep 0.5
+
+./hangman-bench -c "$CLIENTS" -d "$DURATION" > /dev/null &
+bench=$!
+sleep 1
+
+failed=0
+killed=0
+last=$(stat requests)
+
+for i in $(seq 2 "$DURATION"); do
+    for victim in $(pgrep -P "$bench" | shuf -n 2); do
+        kill -KILL "$victim" && killed=$((killed + 1))
+    done
+
+    sleep 1
+    requests=$(stat requests)
+
+    if [ "$requests" -le "$last" ]; then
+        echo "stalled after $killed kills: $requests requests" >&2
+        failed=1
+    fi
+
+    last=$requests
+done
+
+wait "$bench"
+
+# Slots of killed bots are reclaimed within a second
+sleep 2
+
+if ! ./hangman-bench -c 64 -d 2 -g 1 > /dev/null; then
+    echo "second benchmark failed" >&2
+    failed=1
+fi
+
+sessions=$(stat sessions)
+
+if [ "$sessions" -ne 0 ]; then
+    echo "$sessions sessions of killed bots left" >&2
+    failed=1
+fi
+
+kill -INT "$server"
+wait "$server" 2> /dev/null
+
+echo "{\"killed\":$killed,\"requests\":$last,\"passed\":$((1 - failed))}"
+exit $failed
@@ -0,0 +1,386 @@
+/**
+ * @file bench/game.c
+ * @brief Microbenchmarks of the game logic of hangman-server without its IPC: word ingest,
+ *        session lookup and churn at growing session counts, guess evaluation and response
+ *        marshalling. Reports ns/op, allocations/op and cache misses/op where perf events
+ *        are available
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "hangman-game.h"
+
+#define WORDS    1000000
+#define LOOKUPS  2000000
+#define CHURN    200000
+#define GUESSES  4000000
+#define REQUESTS 2000000
+
+static uint64_t allocs; // Allocations by the game code, counted if the allocator is wrapped
+static int misses = -1; // Perf event of the cache misses of this thread, -1 if not available
+
+#ifdef BENCH_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocs++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    allocs++;
+    return __real_realloc(pointer, size);
+}
+#endif
+
+/**
+ * Counters at the start of a measurement
+ */
+struct hangmanSample {
+    double time;
+    uint64_t allocs;
+    uint64_t misses;
+};
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Opens the cache miss counter of this thread, user space only
+ */
+static void countersOpen(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    misses = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+/**
+ * Reads the cache miss counter
+ * @return Misses so far, 0 without perf events
+ */
+static uint64_t countersRead(void) {
+    uint64_t value = 0;
+
+    if (misses != -1 && read(misses, &value, sizeof(value)) != sizeof(value)) {
+        value = 0;
+    }
+
+    return value;
+}
+
+/**
+ * Starts a measurement
+ * @param sample Receives the counters
+ */
+static void begin(struct hangmanSample *sample) {
+    sample->allocs = allocs;
+    sample->misses = countersRead();
+    sample->time = now();
+}
+
+/**
+ * Ends a measurement and prints it
+ * @param name   Operation
+ * @param sample Counters at the start
+ * @param ops    Operations done
+ */
+static void report(const char *name, const struct hangmanSample *sample, long ops) {
+    double elapsed = now() - sample->time;
+    uint64_t missed = countersRead() - sample->misses;
+    char allocations[32] = "-";
+    char missesPerOp[32] = "-";
+
+#ifdef BENCH_ALLOCS
+    (void)snprintf(allocations, sizeof(allocations), "%.3f", (double)(allocs - sample->allocs) / ops);
+#endif
+
+    if (misses != -1) {
+        (void)snprintf(missesPerOp, sizeof(missesPerOp), "%.3f", (double)missed / ops);
+    }
+
+    (void)printf("%-32s %10.1f %12s %12s\n", name, elapsed / ops, allocations, missesPerOp);
+}
+
+/**
+ * Writes a dictionary of random lowercase words (3 to 14 letters)
+ * @param file  Destination
+ * @param count Number of words
+ */
+static void generate(FILE *file, long count) {
+    unsigned int seed = 7;
+
+    for (long i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int length = 3 + (int)((seed >> 16) % 12);
+
+        for (int j = 0; j < length; j++) {
+            seed = seed * 1103515245u + 12345u;
+            (void)fputc('a' + (int)((seed >> 16) % 26), file);
+        }
+
+        (void)fputc('\n', file);
+    }
+}
+
+/**
+ * Ingest of a word list, the work behind loading the dictionary of the server
+ * @param  dicts Receives the words
+ * @return       0 on success, -1 on error
+ */
+static int ingest(struct hangmanDicts *dicts) {
+    struct hangmanSample sample;
+    struct hangmanWords words;
+    FILE *file = tmpfile();
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    generate(file, WORDS);
+
+    // Read once to warm the page cache, then for the measurement
+    rewind(file);
+    wordsInit(&words);
+
+    if (wordsRead(&words, file) == -1) {
+        (void)fclose(file);
+        return -1;
+    }
+
+    rewind(file);
+    begin(&sample);
+
+    if (wordsRead(&dicts->current->words, file) == -1) {
+        (void)fclose(file);
+        wordsFree(&words);
+        return -1;
+    }
+
+    report("wordsRead (per word)", &sample, WORDS);
+    (void)fclose(file);
+
+    struct hangmanWords added;
+    wordsInit(&added);
+    begin(&sample);
+
+    for (size_t i = 0; i < words.count; i++) {
+        if (wordsAdd(&added, wordAt(&words, i), words.length[i]) == -1) {
+            wordsFree(&added);
+            wordsFree(&words);
+            return -1;
+        }
+    }
+
+    report("wordsAdd", &sample, (long)words.count);
+    wordsFree(&added);
+    wordsFree(&words);
+
+    return dictBuild(dicts, dicts->current);
+}
+
+/**
+ * Session lookup and churn of a game with a number of sessions
+ * @param  dicts Word stores
+ * @param  count Sessions
+ * @return       0 on success, -1 on error
+ */
+static int sessions(struct hangmanDicts *dicts, int count) {
+    struct hangmanSample sample;
+    struct hangmanGame game;
+    char name[64];
+    unsigned int seed = 42;
+
+    if (gameInit(&game, dicts, (size_t)count + 1) == -1) {
+        return -1;
+    }
+
+    // IDs of no running process, roughly sequential like pids
+    begin(&sample);
+
+    for (int i = 0; i < count; i++) {
+        if (addClient(&game, 4000000 + i * 7) == NULL) {
+            gameFree(&game);
+            return -1;
+        }
+    }
+
+    (void)snprintf(name, sizeof(name), "addClient (%d)", count);
+    report(name, &sample, count);
+
+    long found = 0;
+    begin(&sample);
+
+    for (int i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        found += getClient(&game, 4000000 + (int)((seed >> 8) % (unsigned int)count) * 7) != NULL;
+    }
+
+    (void)snprintf(name, sizeof(name), "getClient (%d)", count);
+    report(name, &sample, LOOKUPS);
+
+    if (found != LOOKUPS) {
+        gameFree(&game);
+        return -1;
+    }
+
+    // The oldest client leaves, a new one connects
+    begin(&sample);
+
+    for (int i = 0; i < CHURN; i++) {
+        removeClient(&game, 4000000 + i * 7);
+
+        if (addClient(&game, 4000000 + (count + i) * 7) == NULL) {
+            gameFree(&game);
+            return -1;
+        }
+    }
+
+    (void)snprintf(name, sizeof(name), "removeClient+addClient (%d)", count);
+    report(name, &sample, CHURN);
+
+    gameFree(&game);
+
+    return 0;
+}
+
+/**
+ * Guess evaluation and a whole guess request in both response formats
+ * @param  dicts Word stores
+ * @return       0 on success, -1 on error
+ */
+static int guesses(struct hangmanDicts *dicts) {
+    struct hangmanSample sample;
+    struct hangmanGame game;
+    struct hangmanData request;
+    struct hangmanReply reply;
+    const struct hangmanWords *words = &dicts->current->words;
+
+    if (gameInit(&game, dicts, 1) == -1) {
+        return -1;
+    }
+
+    struct hangmanData *client = addClient(&game, 4000000);
+
+    if (client == NULL) {
+        gameFree(&game);
+        return -1;
+    }
+
+    long hits = 0;
+    begin(&sample);
+
+    for (long i = 0; i < GUESSES; i++) {
+        int index = (int)(i % (long)words->count);
+
+        hits += clearWord(words, client, index, (char)('A' + i % 26)) != 0;
+    }
+
+    report("clearWord", &sample, GUESSES);
+
+    if (hits == 0) {
+        gameFree(&game);
+        return -1;
+    }
+
+    // Games played to the end, a new game starts whenever one is over
+    static const char *order = "ETAOINSHRDLCUMWFGYPBVKJXQZ";
+    static const char *formats[] = { "handleRequest (compact)", "handleRequest (full)" };
+
+    for (int format = 0; format < 2; format++) {
+        int next = 0;
+
+        memset(&request, 0, sizeof(request));
+        request.id = 4000000;
+        begin(&sample);
+
+        for (long i = 0; i < REQUESTS; i++) {
+            int status = getClient(&game, request.id)->status;
+
+            request.format = format == 0 ? FORMAT_COMPACT : FORMAT_FULL;
+            request.signal = 0;
+            request.batch = 0;
+            request.send = status >= 2 ? order[next++ % 26] : 'Y';
+            next = status >= 2 ? next : 0;
+
+            if (handleRequest(&game, &request, format == 0 ? &reply : NULL) < 0) {
+                gameFree(&game);
+                return -1;
+            }
+        }
+
+        report(formats[format], &sample, REQUESTS);
+    }
+
+    gameFree(&game);
+
+    return 0;
+}
+
+int main(void) {
+    static const int counts[] = { 100, 10000, 100000 };
+    struct hangmanDicts dicts;
+
+    countersOpen();
+
+    if (dictsInit(&dicts, NULL) == -1) {
+        (void)fprintf(stderr, "bench/game: dictsInit\n");
+        return EXIT_FAILURE;
+    }
+
+    (void)printf("%-32s %10s %12s %12s\n", "operation", "ns/op", "allocs/op", "misses/op");
+
+    if (ingest(&dicts) == -1) {
+        (void)fprintf(stderr, "bench/game: ingest failed\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        if (sessions(&dicts, counts[i]) == -1) {
+            (void)fprintf(stderr, "bench/game: sessions failed\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (guesses(&dicts) == -1) {
+        (void)fprintf(stderr, "bench/game: guesses failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (misses == -1) {
+        (void)printf("(no perf events, cache misses not counted)\n");
+    }
+
+    dictsFree(&dicts);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file bench/pingpong.c
+ * @brief Benchmark of the wakeup modes, round trip between two processes with process-shared
+ *        semaphores and with futex events at several spin limits
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "hangman-futex.h"
+
+#define ROUNDS 100000
+
+struct pingPong {
+    sem_t ping;
+    sem_t pong;
+    struct hangmanEvent pinged;
+    struct hangmanEvent ponged;
+};
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Plays ROUNDS round trips between a child and its parent
+ * @param  shared Semaphores and events in shared memory
+ * @param  spin   Spin limit for futex events, -1 for semaphores
+ * @return        Nanoseconds per round trip, negative on an error
+ */
+static double rounds(struct pingPong *shared, int spin) {
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        return -1;
+    }
+
+    if (pid == 0) {
+        unsigned int estimate = 0;
+
+        for (int i = 0; i < ROUNDS; i++) {
+            if (spin < 0) {
+                while (sem_wait(&shared->ping) < 0) {
+                    // Retry
+                }
+
+                (void)sem_post(&shared->pong);
+            } else {
+                while (eventWait(&shared->pinged, &estimate, (unsigned int)spin, NULL) < 0) {
+                    // Retry
+                }
+
+                (void)eventPost(&shared->ponged);
+            }
+        }
+
+        _exit(EXIT_SUCCESS);
+    }
+
+    unsigned int estimate = 0;
+    double start = now();
+
+    for (int i = 0; i < ROUNDS; i++) {
+        if (spin < 0) {
+            (void)sem_post(&shared->ping);
+
+            while (sem_wait(&shared->pong) < 0) {
+                // Retry
+            }
+        } else {
+            (void)eventPost(&shared->pinged);
+
+            while (eventWait(&shared->ponged, &estimate, (unsigned int)spin, NULL) < 0) {
+                // Retry
+            }
+        }
+    }
+
+    double elapsed = (now() - start) / ROUNDS;
+    (void)waitpid(pid, NULL, 0);
+
+    return elapsed;
+}
+
+int main(void) {
+    static const int spins[] = { -1, 0, 100, 1000, 10000 };
+    struct pingPong *shared = (struct pingPong *)mmap(NULL, sizeof(struct pingPong), PROT_READ | PROT_WRITE,
+                                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (shared == MAP_FAILED || sem_init(&shared->ping, 1, 0) == -1 || sem_init(&shared->pong, 1, 0) == -1) {
+        (void)fprintf(stderr, "bench/pingpong: shared memory\n");
+        return EXIT_FAILURE;
+    }
+
+    eventInit(&shared->pinged);
+    eventInit(&shared->ponged);
+
+    (void)printf("%-14s %14s   (%li CPUs)\n", "wakeup", "round trip ns", sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (size_t s = 0; s < sizeof(spins) / sizeof(spins[0]); s++) {
+        double ns = rounds(shared, spins[s]);
+
+        if (ns < 0) {
+            (void)fprintf(stderr, "bench/pingpong: fork\n");
+            return EXIT_FAILURE;
+        }
+
+        if (spins[s] < 0) {
+            (void)printf("%-14s %14.0f\n", "sem", ns);
+        } else {
+            char mode[32];
+            (void)snprintf(mode, sizeof(mode), "futex:%i", spins[s]);
+            (void)printf("%-14s %14.0f\n", mode, ns);
+        }
+    }
+
+    (void)sem_destroy(&shared->ping);
+    (void)sem_destroy(&shared->pong);
+    (void)munmap(shared, sizeof(struct pingPong));
+
+    return EXIT_SUCCESS;
+}
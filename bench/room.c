@@ -0,0 +1,189 @@
+/**
+ * @file bench/room.c
+ * @brief Snapshot throughput of room spectators: 1 to 8 reader processes copy the room state
+ *        while a writer process publishes a new state every 100 us. Every snapshot is checked
+ *        for being consistent
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "hangman-room.h"
+
+#define DURATION       1 // Seconds per reader count
+#define WRITE_INTERVAL 100000 // ns between two states
+#define MAX_READERS    8
+
+/**
+ * Results of the processes, shared with the parent
+ */
+struct hangmanBenchRoom {
+    int stop;
+    uint64_t writes;
+    uint64_t reads[MAX_READERS];
+    uint64_t retries[MAX_READERS];
+    uint64_t torn[MAX_READERS]; // Snapshots mixing two states, must stay 0
+};
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * State number n, every field derives from n so a reader can tell a torn copy
+ * @param state Receives the state
+ * @param n     Number of the state
+ */
+static void fill(struct hangmanRoomState *state, uint32_t n) {
+    state->round = n;
+    state->index = (int32_t)n;
+    state->guessedMask = n * 2654435761u;
+    state->guesses = n;
+    state->won = n;
+    state->lost = n;
+    memset(state->word, 'a' + (int)(n % 26), sizeof(state->word) - 1);
+    state->word[sizeof(state->word) - 1] = '\0';
+}
+
+/**
+ * Checks a snapshot
+ * @param  state Snapshot
+ * @return       1 if it is one published state
+ */
+static int consistent(const struct hangmanRoomState *state) {
+    uint32_t n = state->round;
+
+    if (state->index != (int32_t)n || state->guessedMask != n * 2654435761u || state->guesses != n ||
+        state->won != n || state->lost != n) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(state->word) - 1; i++) {
+        if (state->word[i] != 'a' + (int)(n % 26)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Publishes states until stopped
+ */
+static void writer(struct hangmanRoomShm *room, struct hangmanBenchRoom *results) {
+    struct hangmanRoomState state;
+    struct timespec interval = { 0, WRITE_INTERVAL };
+    uint32_t n = 1;
+
+    memset(&state, 0, sizeof(state));
+
+    while (!__atomic_load_n(&results->stop, __ATOMIC_ACQUIRE)) {
+        fill(&state, n++);
+        roomPublish(room, &state);
+        (void)nanosleep(&interval, NULL);
+    }
+
+    results->writes = n - 1;
+}
+
+/**
+ * Copies snapshots until stopped
+ */
+static void reader(struct hangmanRoomShm *room, struct hangmanBenchRoom *results, int index) {
+    struct hangmanRoomState state;
+    uint64_t reads = 0, retries = 0, torn = 0;
+    uint32_t seq;
+
+    while (!__atomic_load_n(&results->stop, __ATOMIC_RELAXED)) {
+        retries += roomRead(room, &state, &seq);
+        torn += !consistent(&state);
+        reads++;
+    }
+
+    results->reads[index] = reads;
+    results->retries[index] = retries;
+    results->torn[index] = torn;
+}
+
+int main(void) {
+    static const int counts[] = { 1, 2, 4, 8 };
+    size_t size = sizeof(struct hangmanRoomShm) + sizeof(struct hangmanBenchRoom);
+    void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (mapping == MAP_FAILED) {
+        (void)fprintf(stderr, "bench/room: mmap\n");
+        return EXIT_FAILURE;
+    }
+
+    struct hangmanRoomShm *room = (struct hangmanRoomShm *)mapping;
+    struct hangmanBenchRoom *results = (struct hangmanBenchRoom *)(room + 1);
+    struct hangmanRoomState first;
+    int failed = 0;
+
+    fill(&first, 0);
+    roomPublish(room, &first);
+
+    (void)printf("%8s %14s %14s %12s %10s %6s\n", "readers", "reads/s", "per reader", "retries/op", "writes/s", "torn");
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        int readers = counts[c];
+        pid_t pids[MAX_READERS + 1];
+
+        memset(results, 0, sizeof(*results));
+
+        for (int i = 0; i <= readers; i++) {
+            pids[i] = fork();
+
+            if (pids[i] == -1) {
+                (void)fprintf(stderr, "bench/room: fork\n");
+                return EXIT_FAILURE;
+            }
+
+            if (pids[i] == 0) {
+                if (i == readers) {
+                    writer(room, results);
+                } else {
+                    reader(room, results, i);
+                }
+
+                _exit(EXIT_SUCCESS);
+            }
+        }
+
+        double start = now();
+        (void)sleep(DURATION);
+        __atomic_store_n(&results->stop, 1, __ATOMIC_RELEASE);
+
+        for (int i = 0; i <= readers; i++) {
+            (void)waitpid(pids[i], NULL, 0);
+        }
+
+        double elapsed = (now() - start) / 1e9;
+        uint64_t reads = 0, retries = 0, torn = 0;
+
+        for (int i = 0; i < readers; i++) {
+            reads += results->reads[i];
+            retries += results->retries[i];
+            torn += results->torn[i];
+        }
+
+        (void)printf("%8d %14.0f %14.0f %12.6f %10.0f %6llu\n", readers, reads / elapsed, reads / elapsed / readers,
+                     reads != 0 ? (double)retries / reads : 0.0, results->writes / elapsed, (unsigned long long)torn);
+
+        failed |= torn != 0;
+    }
+
+    (void)munmap(mapping, size);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
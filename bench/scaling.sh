@@ -0,0 +1,21 @@
+#!/bin/sh
+# Runs hangman-bench against hangman-server with 1 to N worker threads,
+# one JSON line per worker count.
+#
+# Usage: bench/scaling.sh [max-workers] [clients] [seconds] [word-list]
+
+WORKERS=${1:-$(nproc)}
+CLIENTS=${2:-32}
+DURATION=${3:-5}
+WORDS=${4:-words.txt}
+
+for j in $(seq 1 "$WORKERS"); do
+    ./hangman-server -j "$j" "$WORDS" > /dev/null &
+    server=$!
+    sleep 0.5
+
+    ./hangman-bench -c "$CLIENTS" -d "$DURATION" | sed "s/^{/{\"workers\":$j,/"
+
+    kill -INT "$server"
+    wait "$server" 2> /dev/null
+done
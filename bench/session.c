@@ -0,0 +1,88 @@
+/**
+ * @file bench/session.c
+ * @brief Benchmark of the session table, lookup and churn cost for 10 to 100k sessions
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hangman-session.h"
+
+#define LOOKUPS 4000000
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void) {
+    static const int sizes[] = { 10, 100, 1000, 10000, 100000 };
+    unsigned int seed = 42;
+
+    (void)printf("%-10s %14s %14s\n", "sessions", "lookup ns/op", "churn ns/op");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        struct hangmanSessions sessions;
+        struct hangmanData *data = (struct hangmanData *)calloc(n + 1, sizeof(struct hangmanData));
+        int *probe = (int *)malloc(LOOKUPS * sizeof(int));
+
+        if (data == NULL || probe == NULL || sessionInit(&sessions, 8) == -1) {
+            (void)fprintf(stderr, "bench/session: out of memory\n");
+            return EXIT_FAILURE;
+        }
+
+        for (int i = 0; i < n; i++) {
+            data[i].id = 1000 + i * 7;      // pids are roughly sequential
+            (void)sessionPut(&sessions, &data[i]);
+        }
+
+        for (int i = 0; i < LOOKUPS; i++) {
+            seed = seed * 1103515245u + 12345u;
+            probe[i] = 1000 + (int)((seed >> 8) % (unsigned int)n) * 7;
+        }
+
+        long found = 0;
+        double start = now();
+
+        for (int i = 0; i < LOOKUPS; i++) {
+            found += sessionGet(&sessions, probe[i]) != NULL;
+        }
+
+        double lookup = (now() - start) / LOOKUPS;
+
+        // Disconnect one client and connect a new one with a fresh pid
+        struct hangmanData *spare = &data[n];
+        spare->id = 1000 + n * 7;
+        start = now();
+
+        for (int i = 0; i < LOOKUPS; i++) {
+            struct hangmanData *gone = sessionRemove(&sessions, probe[i]);
+
+            if (gone != NULL) {
+                spare->id = gone->id;
+                (void)sessionPut(&sessions, spare);
+                spare = gone;
+            }
+        }
+
+        double churn = (now() - start) / LOOKUPS;
+
+        if (found != LOOKUPS || sessions.count != (size_t)n) {
+            (void)fprintf(stderr, "bench/session: table corrupted\n");
+            return EXIT_FAILURE;
+        }
+
+        (void)printf("%-10i %14.1f %14.1f\n", n, lookup, churn);
+
+        sessionFree(&sessions);
+        free(probe);
+        free(data);
+    }
+
+    return EXIT_SUCCESS;
+}
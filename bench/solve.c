@@ -0,0 +1,100 @@
+/**
+ * @file bench/solve.c
+ * @brief Benchmark of the solver, words filtered per second for every instruction set
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hangman-solver.h"
+
+#define WORDS  1000000
+#define ROUNDS 50
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Writes a dictionary of random lowercase words (3 to 14 letters)
+ * @param file  Destination
+ * @param count Number of words
+ */
+static void generate(FILE *file, long count) {
+    unsigned int seed = 7;
+
+    for (long i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int length = 3 + (int)((seed >> 16) % 12);
+
+        for (int j = 0; j < length; j++) {
+            seed = seed * 1103515245u + 12345u;
+            (void)fputc('a' + (int)((seed >> 16) % 26), file);
+        }
+
+        (void)fputc('\n', file);
+    }
+}
+
+int main(void) {
+    static const char *isas[] = { "scalar", "sse", "avx2" };
+    // Opening guess, a few hits and misses, nearly solved
+    static const char *patterns[] = { "________", "_A____E_", "_AT_ER_S" };
+    static const uint32_t guessed[] = { 0, 1u << ('S' - 'A') | 1u << ('T' - 'A'), 1u << ('O' - 'A') | 1u << ('N' - 'A') };
+
+    FILE *file = tmpfile();
+
+    if (file == NULL) {
+        (void)fprintf(stderr, "bench/solve: tmpfile\n");
+        return EXIT_FAILURE;
+    }
+
+    generate(file, WORDS);
+    rewind(file);
+
+    struct hangmanWords words;
+    struct hangmanSolver solver;
+    wordsInit(&words);
+
+    if (wordsRead(&words, file) == -1 || solverBuild(&solver, &words) == -1) {
+        (void)fprintf(stderr, "bench/solve: load failed\n");
+        return EXIT_FAILURE;
+    }
+
+    int best = solver.isa;
+
+    (void)printf("%-10s %-8s %12s %12s %14s\n", "pattern", "isa", "candidates", "us/rank", "M words/s");
+
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        uint32_t scanned = solver.group[8].count;
+
+        for (int isa = SOLVER_SCALAR; isa <= best; isa++) {
+            char letters[5];
+            uint32_t candidates = 0;
+
+            solver.isa = isa;
+
+            double start = now();
+
+            for (int i = 0; i < ROUNDS; i++) {
+                (void)solverRank(&solver, patterns[p], guessed[p], letters, 5, &candidates);
+            }
+
+            double elapsed = (now() - start) / ROUNDS;
+
+            (void)printf("%-10s %-8s %12u %12.1f %14.0f\n", patterns[p], isas[isa], candidates, elapsed / 1e3,
+                         scanned / elapsed * 1e3);
+        }
+    }
+
+    solverFree(&solver);
+    wordsFree(&words);
+    (void)fclose(file);
+
+    return EXIT_SUCCESS;
+}
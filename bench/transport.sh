@@ -0,0 +1,26 @@
+#!/bin/sh
+# Runs hangman-bench against the shared memory and the Unix socket transport
+# of hangman-server, one JSON line per transport and client count.
+#
+# Usage: bench/transport.sh [seconds] [word-list] [clients...]
+
+DURATION=${1:-5}
+WORDS=${2:-words.txt}
+[ $# -ge 2 ] && shift 2 || shift $#
+CLIENTS=${*:-1 100 10000}
+
+for transport in shm socket; do
+    flag=
+    [ "$transport" = socket ] && flag=-u
+
+    ./hangman-server $flag -v 0 -m 20000 "$WORDS" > /dev/null &
+    server=$!
+    sleep 0.5
+
+    for c in $CLIENTS; do
+        ./hangman-bench $flag -c "$c" -d "$DURATION"
+    done
+
+    kill -INT "$server"
+    wait "$server" 2> /dev/null
+done
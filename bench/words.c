@@ -0,0 +1,77 @@
+/**
+ * @file bench/words.c
+ * @brief Benchmark of the word store, load time and memory for large generated dictionaries
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hangman-words.h"
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Writes a dictionary of random lowercase words (3 to 14 letters)
+ * @param file  Destination
+ * @param count Number of words
+ */
+static void generate(FILE *file, long count) {
+    unsigned int seed = 7;
+
+    for (long i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int length = 3 + (int)((seed >> 16) % 12);
+
+        for (int j = 0; j < length; j++) {
+            seed = seed * 1103515245u + 12345u;
+            (void)fputc('a' + (int)((seed >> 16) % 26), file);
+        }
+
+        (void)fputc('\n', file);
+    }
+}
+
+int main(void) {
+    static const long sizes[] = { 100000, 1000000, 4000000 };
+
+    (void)printf("%-10s %10s %12s %12s %14s\n", "words", "load ms", "ns/word", "store KiB", "bytes/word");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        FILE *file = tmpfile();
+
+        if (file == NULL) {
+            (void)fprintf(stderr, "bench/words: tmpfile\n");
+            return EXIT_FAILURE;
+        }
+
+        generate(file, sizes[s]);
+        rewind(file);
+
+        struct hangmanWords words;
+        wordsInit(&words);
+
+        double start = now();
+
+        if (wordsRead(&words, file) == -1 || words.count != (size_t)sizes[s]) {
+            (void)fprintf(stderr, "bench/words: load failed\n");
+            return EXIT_FAILURE;
+        }
+
+        double elapsed = now() - start;
+
+        (void)printf("%-10ld %10.1f %12.1f %12zu %14.1f\n", sizes[s], elapsed / 1e6, elapsed / sizes[s],
+                     wordsMemory(&words) / 1024, (double)wordsMemory(&words) / sizes[s]);
+
+        wordsFree(&words);
+        (void)fclose(file);
+    }
+
+    return EXIT_SUCCESS;
+}
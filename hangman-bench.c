@@ -0,0 +1,546 @@
+/**
+ * @file hangman-bench.c
+ * @brief Load generator for hangman-server, bots play over the regular protocol and the
+ *        aggregated throughput and latency is written to stdout as one JSON object
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "hangman-conn.h"
+#include "hangman-hist.h"
+#include "hangman-solver.h"
+
+#define FREQUENCY_ORDER "ENISRATDHULCGMOBWFKZPVJYXQ"
+
+enum hangmanStrategy {
+    STRATEGY_RANDOM,
+    STRATEGY_FREQUENCY, // Fixed letter order
+    STRATEGY_SOLVER // Best letters for the candidates of the word list that match the revealed word
+};
+
+struct hangmanBenchStats {
+    uint64_t requests;
+    uint64_t guesses;
+    uint64_t games;
+    uint64_t won;
+    uint64_t lost;
+    uint64_t connects;
+    uint64_t disconnects;
+    uint64_t errors;
+    uint64_t guessTime; // Sum of the round trips of guess requests in ns
+    uint64_t latency[HIST_BUCKETS]; // Round trip of every request in ns
+    uint64_t claim[HIST_BUCKETS]; // Wait for admission in ns
+    uint64_t claimMax;
+};
+
+char *progname;
+
+char format = FORMAT_COMPACT;
+
+char transport = TRANSPORT_SHM;
+
+const char *instance = NULL; // Every bot picks its own from the registry unless -n or HANGMAN_INSTANCE is given
+
+int route = ROUTE_HASH;
+
+struct hangmanWords words;
+
+struct hangmanSolver solver;
+
+/**
+ * Exits the programm and writes a usage description to stderr
+ */
+static void usage(void) {
+    (void)fprintf(stderr, "Usage: %s [-c clients] [-d seconds] [-g games-per-connection] [-s random|frequency|solver] [-w word-list] [-b batch] [-n instance | -r hash|load] [-l | -u]\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Sends one request and records its round trip
+ * @param  conn  Connection with a claimed slot
+ * @param  send  Letter or answer to send
+ * @param  batch Letters guessed by the request, 0 for an answer, more than 1 if they are in conn->data->letters
+ * @param  stats Statistics of the bot
+ * @return       Status of the response, -3 if the connection failed
+ */
+static int request(struct hangmanConn *conn, char send, int batch, struct hangmanBenchStats *stats) {
+    conn->data->id = conn->id;
+    conn->data->send = send;
+    conn->data->signal = 0;
+    conn->data->format = format;
+    conn->data->batch = (short)(batch > 1 ? batch : 0);
+    conn->data->band = 0;
+    conn->data->player = 0;
+
+    uint64_t start = now();
+
+    if (connSubmit(conn) < 0) {
+        stats->errors++;
+        return -3;
+    }
+
+    uint64_t elapsed = now() - start;
+    stats->latency[histBucket(elapsed)]++;
+    stats->requests++;
+
+    if (batch > 0) {
+        stats->guessTime += elapsed;
+    }
+
+    return format == FORMAT_COMPACT ? conn->reply->status : conn->data->status;
+}
+
+/**
+ * Letters guessed so far in the current game
+ * @param  conn Connection with a claimed slot
+ * @return      Mask of the guessed letters
+ */
+static unsigned int guessed(const struct hangmanConn *conn) {
+    return format == FORMAT_COMPACT ? conn->reply->guessedMask : conn->data->guessedMask;
+}
+
+/**
+ * Wrong guesses in the current game
+ * @param  conn Connection with a claimed slot
+ * @return      Number of wrong guesses
+ */
+static int wrongGuesses(const struct hangmanConn *conn) {
+    return format == FORMAT_COMPACT ? conn->reply->wrongGuesses : conn->data->wrongGuesses;
+}
+
+/**
+ * Letters of the last batch the server applied
+ * @param  conn Connection with a claimed slot
+ * @return      Number of applied letters
+ */
+static int applied(const struct hangmanConn *conn) {
+    return format == FORMAT_COMPACT ? conn->reply->applied : conn->data->applied;
+}
+
+/**
+ * Revealed word of the current game
+ * @param  conn Connection with a claimed slot
+ * @param  view Local state of a compact connection, updated with the last reply
+ * @param  send Letter of the last request
+ * @return      Uppercase word with '_' for hidden letters
+ */
+static const char *revealed(const struct hangmanConn *conn, struct hangmanData *view, char send) {
+    if (format == FORMAT_FULL) {
+        return conn->data->word;
+    }
+
+    view->send = send;
+    connApply(conn, view);
+
+    return view->word;
+}
+
+/**
+ * Picks the next letter to guess
+ * @param  guessed   Mask of the letters guessed so far
+ * @param  frequency 1 to guess by letter frequency, 0 to guess randomly
+ * @param  seed      State of the random generator
+ * @return           Uppercase letter that was not guessed yet
+ */
+static char pick(unsigned int guessed, int frequency, unsigned int *seed) {
+    if (frequency) {
+        for (const char *letter = FREQUENCY_ORDER; *letter != '\0'; letter++) {
+            if ((guessed & (1u << (*letter - 'A'))) == 0) {
+                return *letter;
+            }
+        }
+    } else {
+        int left = 26 - __builtin_popcount(guessed & 0x3ffffff);
+
+        if (left > 0) {
+            *seed = *seed * 1103515245u + 12345u;
+            int n = (int)((*seed >> 8) % (unsigned int)left);
+
+            for (int letter = 0; letter < 26; letter++) {
+                if ((guessed & (1u << letter)) == 0 && n-- == 0) {
+                    return (char)('A' + letter);
+                }
+            }
+        }
+    }
+
+    return 'A';
+}
+
+/**
+ * Picks the next letters to guess
+ * @param  word     Revealed word
+ * @param  guessed  Mask of the letters guessed so far
+ * @param  strategy hangmanStrategy
+ * @param  seed     State of the random generator
+ * @param  letters  Receives the letters, best first
+ * @param  max      Letters to pick
+ * @return          Number of letters picked, less than max once every letter is guessed
+ */
+static int choose(const char *word, unsigned int guessed, int strategy, unsigned int *seed, char *letters, int max) {
+    int count = 0;
+
+    if (strategy == STRATEGY_SOLVER) {
+        count = solverRank(&solver, word, guessed & 0x3ffffff, letters, max, NULL);
+
+        for (int i = 0; i < count; i++) {
+            guessed |= 1u << (letters[i] - 'A');
+        }
+    }
+
+    // Guesses the next letters as if none of them were wrong, the solver falls back once no word matches
+    while (count < max && (guessed & 0x3ffffff) != 0x3ffffff) {
+        letters[count] = pick(guessed, strategy != STRATEGY_RANDOM, seed);
+        guessed |= 1u << (letters[count] - 'A');
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Plays until the deadline, reconnecting after a number of games
+ * @param stats     Statistics of the bot
+ * @param deadline  End of the benchmark
+ * @param games     Games per connection
+ * @param strategy  hangmanStrategy
+ * @param batch     Letters per guess request, 1 for single guesses
+ */
+static void bot(struct hangmanBenchStats *stats, uint64_t deadline, int games, int strategy, int batch) {
+    struct hangmanConn conn;
+    struct hangmanData view;
+    unsigned int seed = (unsigned int)getpid();
+
+    char routed[INSTANCE_LENGTH];
+    const char *name = instance;
+
+    memset(&view, 0, sizeof(view));
+
+    if (name == NULL) {
+        connRoute(transport, getpid(), (enum hangmanRoute)route, routed);
+        name = routed;
+    }
+
+    if ((transport == TRANSPORT_SOCKET ? connOpenSocket(&conn, name) : connOpen(&conn, name)) < 0) {
+        stats->errors++;
+        return;
+    }
+
+    while (now() < deadline) {
+        uint64_t start = now();
+
+        if (connClaim(&conn, getpid()) < 0) {
+            stats->errors++;
+            break;
+        }
+
+        uint64_t waited = now() - start;
+        stats->claim[histBucket(waited)]++;
+
+        if (waited > stats->claimMax) {
+            stats->claimMax = waited;
+        }
+
+        // request counts the error itself
+        if (request(&conn, '\0', 0, stats) < -2) {
+            break;
+        }
+
+        stats->connects++;
+
+        int status = 0;
+
+        for (int game = 0; game < games && now() < deadline; game++) {
+            status = request(&conn, 'Y', 0, stats);
+            const char *word = revealed(&conn, &view, 'Y');
+
+            while (status >= 2) {
+                char letters[MAX_BATCH];
+                int count = choose(word, guessed(&conn), strategy, &seed, letters, batch);
+
+                if (batch > 1) {
+                    (void)memcpy(conn.data->letters, letters, (size_t)count);
+                    status = request(&conn, letters[0], count, stats);
+                    stats->guesses += (uint64_t)applied(&conn);
+                } else {
+                    status = request(&conn, letters[0], 1, stats);
+                    stats->guesses++;
+                }
+
+                word = revealed(&conn, &view, letters[0]);
+            }
+
+            if (status != 0) {
+                break;
+            }
+
+            stats->games++;
+
+            if (wrongGuesses(&conn) == 9) {
+                stats->lost++;
+            } else {
+                stats->won++;
+            }
+        }
+
+        if (status == 0) {
+            status = request(&conn, 'N', 0, stats);
+        }
+
+        connRelease(&conn);
+        stats->disconnects++;
+
+        if (status < -2) {
+            break;
+        }
+    }
+
+    connClose(&conn);
+}
+
+/**
+ * Main
+ * @brief     Main Function
+ * @param     argc Number of arguments
+ * @param     argv Array of arguments of type char*
+ * @result    int EXIT_SUCCESS or in case of an error EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    progname = argv[0];
+    int clients = 8;
+    int seconds = 5;
+    int games = 10;
+    int strategy = STRATEGY_FREQUENCY;
+    int batch = 1;
+    char *list = NULL;
+    char *end;
+    int routed = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "b:c:d:g:n:r:s:w:lu")) != -1) {
+        switch (c) {
+            case 'u':
+                transport = TRANSPORT_SOCKET;
+                break;
+
+            case 'b':
+                batch = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || batch < 1 || batch > MAX_BATCH) {
+                    usage();
+                }
+
+                break;
+
+            case 'l':
+                format = FORMAT_FULL;
+                break;
+
+            case 'c':
+                clients = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || clients < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 'd':
+                seconds = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || seconds < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 'g':
+                games = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || games < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 's':
+                if (strcmp(optarg, "random") == 0) {
+                    strategy = STRATEGY_RANDOM;
+                } else if (strcmp(optarg, "frequency") == 0) {
+                    strategy = STRATEGY_FREQUENCY;
+                } else if (strcmp(optarg, "solver") == 0) {
+                    strategy = STRATEGY_SOLVER;
+                } else {
+                    usage();
+                }
+
+                break;
+
+            case 'w':
+                list = optarg;
+                break;
+
+            case 'n':
+                instance = optarg;
+                break;
+
+            case 'r':
+                if (strcmp(optarg, "hash") == 0) {
+                    route = ROUTE_HASH;
+                } else if (strcmp(optarg, "load") == 0) {
+                    route = ROUTE_LOAD;
+                } else {
+                    usage();
+                }
+
+                routed = 1;
+                break;
+
+            case '?':
+                usage();
+                break;
+
+            default:
+                assert(0);
+        }
+    }
+
+    if (argc != optind || (format == FORMAT_FULL && transport == TRANSPORT_SOCKET) || (strategy == STRATEGY_SOLVER) != (list != NULL) || (instance != NULL && routed)) {
+        usage();
+    }
+
+    if (instance == NULL && !routed) {
+        instance = instanceDefault();
+    }
+
+    if (instance != NULL && !instanceValid(instance)) {
+        (void)fprintf(stderr, "%s: Invalid instance name\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    // Loaded once, the bots share the pages after the fork
+    if (list != NULL) {
+        FILE *file = fopen(list, "r");
+
+        wordsInit(&words);
+
+        if (file == NULL || (wordsIsCompiled(file) ? wordsMap(&words, list) : wordsRead(&words, file)) == -1 || solverBuild(&solver, &words) == -1) {
+            (void)fprintf(stderr, "%s: Could not load %s\n", progname, list);
+            return EXIT_FAILURE;
+        }
+
+        (void)fclose(file);
+    }
+
+    const char *admission = "none";
+
+    if (transport == TRANSPORT_SHM) {
+        struct hangmanConn probe;
+        char name[INSTANCE_LENGTH];
+
+        if (instance == NULL) {
+            connRoute(transport, getpid(), (enum hangmanRoute)route, name);
+        }
+
+        if (connOpen(&probe, instance != NULL ? instance : name) == 0) {
+            admission = probe.shm->admission == ADMISSION_FIFO ? "fifo" : "sem";
+        }
+
+        connClose(&probe);
+    }
+
+    // One statistics block per bot, written by the bot and summed up by the parent
+    struct hangmanBenchStats *stats = (struct hangmanBenchStats *)mmap(NULL, clients * sizeof(struct hangmanBenchStats),
+                                                                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (stats == MAP_FAILED) {
+        (void)fprintf(stderr, "%s: mmap\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t start = now();
+    uint64_t deadline = start + (uint64_t)seconds * 1000000000u;
+
+    for (int i = 0; i < clients; i++) {
+        pid_t pid = fork();
+
+        if (pid == -1) {
+            (void)fprintf(stderr, "%s: fork\n", progname);
+            clients = i;
+            break;
+        } else if (pid == 0) {
+            bot(&stats[i], deadline, games, strategy, batch);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    while (wait(NULL) > 0) {
+        // Wait for all bots
+    }
+
+    static const char *strategies[] = { "random", "frequency", "solver" };
+    double elapsed = (now() - start) / 1e9;
+    struct hangmanBenchStats total;
+    memset(&total, 0, sizeof(total));
+
+    for (int i = 0; i < clients; i++) {
+        total.requests += stats[i].requests;
+        total.guesses += stats[i].guesses;
+        total.games += stats[i].games;
+        total.won += stats[i].won;
+        total.lost += stats[i].lost;
+        total.connects += stats[i].connects;
+        total.disconnects += stats[i].disconnects;
+        total.errors += stats[i].errors;
+        total.guessTime += stats[i].guessTime;
+
+        if (stats[i].claimMax > total.claimMax) {
+            total.claimMax = stats[i].claimMax;
+        }
+
+        for (int j = 0; j < HIST_BUCKETS; j++) {
+            total.latency[j] += stats[i].latency[j];
+            total.claim[j] += stats[i].claim[j];
+        }
+    }
+
+    (void)printf("{\"clients\":%i,\"transport\":\"%s\",\"format\":\"%s\",\"strategy\":\"%s\",\"batch\":%i,\"seconds\":%.3f,\"requests\":%llu,\"guesses\":%llu,"
+                 "\"games\":%llu,\"won\":%llu,\"lost\":%llu,\"errors\":%llu,"
+                 "\"requests_per_sec\":%.1f,\"guesses_per_sec\":%.1f,\"connects_per_sec\":%.1f,\"disconnects_per_sec\":%.1f,\"ns_per_guess\":%.1f,"
+                 "\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,"
+                 "\"admission\":\"%s\",\"claim_p50_ns\":%llu,\"claim_p99_ns\":%llu,\"claim_p999_ns\":%llu,\"claim_max_ns\":%llu}\n",
+                 clients, transport == TRANSPORT_SOCKET ? "socket" : "shm", format == FORMAT_COMPACT ? "compact" : "full", strategies[strategy], batch, elapsed,
+                 (unsigned long long)total.requests, (unsigned long long)total.guesses, (unsigned long long)total.games,
+                 (unsigned long long)total.won, (unsigned long long)total.lost, (unsigned long long)total.errors,
+                 total.requests / elapsed, total.guesses / elapsed, total.connects / elapsed, total.disconnects / elapsed,
+                 total.guesses > 0 ? (double)total.guessTime / total.guesses : 0.0,
+                 (unsigned long long)histPercentile(total.latency, 0.5), (unsigned long long)histPercentile(total.latency, 0.99),
+                 (unsigned long long)histPercentile(total.latency, 0.999),
+                 admission, (unsigned long long)histPercentile(total.claim, 0.5), (unsigned long long)histPercentile(total.claim, 0.99),
+                 (unsigned long long)histPercentile(total.claim, 0.999), (unsigned long long)total.claimMax);
+
+    (void)munmap(stats, clients * sizeof(struct hangmanBenchStats));
+    solverFree(&solver);
+
+    if (list != NULL) {
+        wordsFree(&words);
+    }
+
+    return total.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -5,11 +5,116 @@
  * @brief The hangman client that connects to a hangman server
  */
 #include "hangman.h"
+#include "hangman-conn.h"
+#include "hangman-room.h"
 
-short isLocked = 0;
+struct hangmanConn conn;
 
 int id;
 
+char format = FORMAT_COMPACT;
+
+char transport = TRANSPORT_SHM;
+
+char band = 0;
+
+uint64_t player = 0; // Anonymous unless -p is given
+
+const char *instance = NULL; // Picked from the registry unless -n or HANGMAN_INSTANCE is given
+
+int route = -1; // ROUTE_HASH unless -r is given
+
+int spectator = 0; // Watches the room of the server if -S is given
+
+/**
+ * Local game state, rebuilt from compact responses
+ */
+struct hangmanData view;
+
+/**
+ * Sends the request in shared to the server and waits for the response
+ */
+static void submit(void) {
+    if (format == FORMAT_COMPACT) {
+        conn.data->id = shared->id;
+        conn.data->send = shared->send;
+        conn.data->signal = shared->signal;
+        conn.data->batch = shared->batch;
+        conn.data->band = shared->band;
+        conn.data->player = shared->player;
+        (void)memcpy(conn.data->letters, shared->letters, (size_t)shared->batch);
+    }
+
+    conn.data->format = format;
+
+    if (connSubmit(&conn) < 0) {
+        bail_out("Lost connection to server");
+    }
+
+    if (format == FORMAT_COMPACT) {
+        connApply(&conn, shared);
+    }
+}
+
+/**
+ * Prints the room of a server in room mode whenever it changes, without a slot or a session.
+ * Returns once the server is gone
+ * @param name Instance of the server
+ */
+static void spectate(const char *name) {
+    char roomName[NAME_LENGTH];
+    struct hangmanRoomState state;
+    struct timespec interval = { 1, 0 };
+    uint32_t seq = 0;
+
+    instanceName(roomName, ROOM_NAME, name);
+
+    struct hangmanRoomShm *room = roomMap(roomName, 0);
+
+    if (room == NULL) {
+        bail_out("No room to watch, start the server with -R");
+    }
+
+    while (1) {
+        if (roomWait(room, seq, &interval) == -1) {
+            // The page outlives a server that was killed
+            if (processStarted(room->server) != room->started) {
+                break;
+            }
+
+            continue;
+        }
+
+        (void)roomRead(room, &state, &seq);
+
+        (void)printf("\n_______________________________________________________________________________\n");
+
+        if (state.round == 0) {
+            (void)printf("Waiting for the first player\n");
+            fflush(stdout);
+            continue;
+        }
+
+        (void)printf("Round %u (%u players): %s\n", state.round, state.players, state.word);
+
+        for (int i = 0; i < 26; i++) {
+            (void)printf("%c ", (state.guessedMask & (1u << i)) ? 'A' + i : '_');
+        }
+
+        (void)printf("\nWrong guesses: %i/9\n%s\n", state.wrongGuesses, failureDrawing[state.wrongGuesses]);
+
+        if (state.status == 0) {
+            (void)printf("Round %s\n", state.wrongGuesses == 9 ? "LOST" : "WON");
+        }
+
+        (void)printf("Rounds: %u W, %u L\n", state.won, state.lost);
+        fflush(stdout);
+    }
+
+    roomUnmap(room);
+    (void)printf("\nServer is gone\n");
+}
+
 /**
  * Main
  * @brief     Main Function
@@ -21,9 +126,58 @@ int main(int argc, char *argv[]) {
     progname = argv[0];
 
     int c;
+    char *end;
 
-    while ( (c = getopt(argc, argv, "")) != -1) {
+    while ( (c = getopt(argc, argv, "d:ln:p:r:Su")) != -1) {
         switch (c) {
+            case 'd': {
+                long difficulty = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || difficulty < 0 || difficulty > DIFFICULTY_BANDS) {
+                    usage();
+                }
+
+                band = (char)difficulty;
+                break;
+            }
+
+            case 'l': {
+                format = FORMAT_FULL;
+                break;
+            }
+
+            case 'n': {
+                instance = optarg;
+                break;
+            }
+
+            case 'p': {
+                player = playerKey(optarg);
+                break;
+            }
+
+            case 'r': {
+                if (strcmp(optarg, "hash") == 0) {
+                    route = ROUTE_HASH;
+                } else if (strcmp(optarg, "load") == 0) {
+                    route = ROUTE_LOAD;
+                } else {
+                    usage();
+                }
+
+                break;
+            }
+
+            case 'S': {
+                spectator = 1;
+                break;
+            }
+
+            case 'u': {
+                transport = TRANSPORT_SOCKET;
+                break;
+            }
+
             case '?': {
                 usage();
                 break;
@@ -35,97 +189,76 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (argc != 1) {
+    if (argc != optind || (format == FORMAT_FULL && transport == TRANSPORT_SOCKET) || (instance != NULL && route != -1)) {
         usage();
     }
 
-    (void)signal(SIGINT, signalHandler);
-    (void)signal(SIGTERM, signalHandler);
-
-    // MARK: Semaphore
-
-    server = sem_open(SEM_SERVER, 0);
-    client = sem_open(SEM_CLIENT, 0);
-    locked = sem_open(SEM_LOCKED, 0);
-
-    if (server == SEM_FAILED || client == SEM_FAILED || locked == SEM_FAILED) {
-        bail_out("Could not connect to server");
+    if (instance == NULL && route == -1) {
+        instance = instanceDefault();
     }
 
-    // MARK: Shared Memory
+    if (instance != NULL && !instanceValid(instance)) {
+        bail_out("Invalid instance name");
+    }
 
-    int shm = shm_open(SHM_NAME, O_RDWR, PERMISSION);
+    // MARK: Connection
 
-    if (shm == -1) {
-        bail_out("Could not connect to server");
-    }
+    id = getpid();
 
-    // if (ftruncate(shm, sizeof(struct hangmanData)) == -1) { bail_out("ftruncate"); }
+    char routed[INSTANCE_LENGTH];
 
-    shared = (struct hangmanData *)mmap(NULL, sizeof(struct hangmanData), PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+    // A named player always lands on the same instance, and so finds its score there
+    if (instance == NULL) {
+        connRoute(transport, player != 0 ? (int)(player ^ player >> 32) : id, route == -1 ? ROUTE_HASH : route, routed);
+        instance = routed;
+    }
 
-    if (shared == MAP_FAILED) {
-        bail_out("mmap");
+    // Spectators only read the room page, they need neither a slot nor a session
+    if (spectator) {
+        spectate(instance);
+        exit(EXIT_SUCCESS);
     }
 
-    if (close(shm) == -1) {
-        bail_out("close");
+    (void)signal(SIGINT, signalHandler);
+    (void)signal(SIGTERM, signalHandler);
+
+    if ((transport == TRANSPORT_SOCKET ? connOpenSocket(&conn, instance) : connOpen(&conn, instance)) < 0) {
+        bail_out("Could not connect to server");
     }
 
-    (void)printf("Trying to connect to server...");
+    (void)printf("Trying to connect to server%s%s...", instance[0] != '\0' ? " " : "", instance);
     fflush(stdout);
 
-    if (sem_wait(locked) < 0) {      // Wait until unlocked
-        bail_out("sem_wait(locked)");
+    if (connClaim(&conn, id) < 0) {      // Wait until a slot is free
+        bail_out("No free slot");
     }
 
-    isLocked = 1;
-
-    id = getpid();
+    shared = format == FORMAT_COMPACT ? &view : conn.data;
     shared->id = id;
     shared->signal = 0;
     shared->send = '\0';
-    // shared->send = 'Y';
+    shared->band = band;
+    shared->player = player;
 
-    if (sem_post(client) < 0) {     // Send answer to server
-        bail_out("sem_wait(client)");
-    }
-
-    if (sem_wait(server) < 0) {     // Wait for answer from server
-        bail_out("sem_wait(server)");
-    }
+    submit();
 
     id = shared->id;
     (void)printf("Obtained ID: %i\n", id);
 
-    if (sem_post(locked) < 0) {     // Unlock
-        bail_out("sem_post(locked)");
-    }
-
-    isLocked = 0;
-
     char send = 'Y';
+    char letters[MAX_BATCH];
+    short batch = 0;
 
     while (shared->status > -2) {
-        if (sem_wait(locked) < 0) {              // Wait until unlocked
-            bail_out("sem_wait(locked)");
-        }
-
-        isLocked = 1;
-
         // MARK: Client write
 
         shared->id = id;
         shared->send = send;
         shared->signal = 0;
+        shared->batch = batch;
+        (void)memcpy(shared->letters, letters, (size_t)batch);
 
-        if (sem_post(client) < 0) {             // Send answer to server
-            bail_out("sem_wait(client)");
-        }
-
-        if (sem_wait(server) < 0) {         // Wait for answer from server
-            bail_out("sem_wait(server)");
-        }
+        submit();
 
         // MARK: Client read
 
@@ -136,10 +269,6 @@ int main(int argc, char *argv[]) {
             (void)printf("\n_______________________________________________________________________________\n");
             (void)printf("Server: %s (%i W, %i L)\nExit Game\n", shared->info, shared->clientW, shared->clientL);
 
-            if (sem_post(locked) < 0) {                 // Unlock
-                bail_out("sem_post(locked)");
-            }
-
             free_alloc();
             exit(EXIT_SUCCESS);
         } else if (status == 2) {
@@ -172,19 +301,24 @@ int main(int argc, char *argv[]) {
             (void)fprintf(stderr, "%s\n", shared->info);
         }
 
-        if (sem_post(locked) < 0) {             // Unlock
-            bail_out("sem_post(locked)");
-        }
-
-        isLocked = 0;
-
         char input[512];
 
+        batch = 0;
+
         if (status >= 2) {
             (void)printf("Guess a letter: ");
 
             if (fgets(input, MAX_WORD_LENGTH, stdin) != NULL) {
                 send = input[0];
+
+                // Several letters on one line are sent as one batch
+                for (char *letter = input; *letter != '\0' && *letter != '\n' && batch < MAX_BATCH; letter++) {
+                    letters[batch++] = (char)toupper((unsigned char)*letter);
+                }
+
+                if (batch == 1) {
+                    batch = 0;
+                }
             }
 
             if (send >= 'a' && send <= 'z') {
@@ -217,36 +351,35 @@ static void bail_out(char *error) {
 }
 
 static void usage(void) {
-    (void)fprintf(stderr, "Usage: %s [input-file]\n", progname);
+    (void)fprintf(stderr, "Usage: %s [-d difficulty] [-n instance | -r hash|load] [-p player] [-l | -u] [-S]\n\t-d difficulty of the words, 1 (easy) to 4 (hard), 0 for any (default)\n\t-l legacy protocol, full responses instead of compact ones\n"
+                  "\t-n connect to the server instance started with -n instance (default " INSTANCE_ENV ")\n"
+                  "\t-p play as a named player, a server started with -P keeps its score across connections\n"
+                  "\t-r pick a running instance by hashing the player or pid (default) or the one with the fewest sessions\n"
+                  "\t-S watch the room of a server started with -R instead of playing\n"
+                  "\t-u connect over the Unix socket of a server started with -u\n"
+                  "\tDuring a game ? asks a server started with -s for a hint\n", progname);
     exit(EXIT_FAILURE);
 }
 
 static void free_alloc(void) {
-	(void)munmap(shared, sizeof(shared));
-    (void)sem_close(client);
-    (void)sem_close(server);
-    (void)sem_close(locked);
+    connClose(&conn);
 }
 
 static void signalHandler(int sig) {
     (void)printf("\n\n");
 
-    if (sig == 2) {
-        if (isLocked) {
-            shared->id = id;
-            shared->signal = 1;
-            (void)sem_post(locked);
-        } else {
-            (void)sem_wait(locked);
-            shared->id = id;
-            shared->signal = 1;
-            (void)sem_post(client);
-            (void)sem_wait(server);
-            (void)sem_post(locked);
-        }
+    if (sig == 2 && conn.slot != -1) {
+        (void)connFinish(&conn);
+
+        shared->id = id;
+        shared->signal = 1;
+        shared->batch = 0;
+        submit();
+    } else if (conn.shm != NULL && shared != NULL && shared != conn.data) {
+        (void)strcpy(shared->info, conn.data->info);     // Set by the server on shutdown
     }
 
-    (void)printf("EXIT (%s, Code: %i)\n", shared->info, sig);
+    (void)printf("EXIT (%s, Code: %i)\n", shared != NULL ? shared->info : "", sig);
     free_alloc();
     exit(sig);
 }
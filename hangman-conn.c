@@ -0,0 +1,456 @@
+/**
+ * @file hangman-conn.c
+ * @brief Client side of the shared memory protocol
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "hangman-conn.h"
+
+#define ADMISSION_NEAR_NS 100000000 // Recheck interval of tickets close to the served one
+#define ADMISSION_FAR_S   1 // Recheck interval of the other tickets
+#define ADMISSION_STALLS  10 // Rechecks before a ticket without known owner is skipped
+#define CONN_TIMEOUT_S    1 // Interval of checking that the server is alive while waiting for a reply
+
+/**
+ * Resets a connection to the unattached state
+ * @param conn      Connection
+ * @param transport TRANSPORT_SHM or TRANSPORT_SOCKET
+ */
+static void connReset(struct hangmanConn *conn, char transport) {
+    conn->transport = transport;
+    conn->shm = NULL;
+    conn->client = NULL;
+    conn->locked = NULL;
+    conn->fd = -1;
+    conn->slot = -1;
+    conn->id = 0;
+    conn->pending = 0;
+    conn->spin = 0;
+    conn->data = NULL;
+    conn->reply = NULL;
+}
+
+int connOpen(struct hangmanConn *conn, const char *instance) {
+    char name[NAME_LENGTH];
+
+    connReset(conn, TRANSPORT_SHM);
+
+    instanceName(name, SEM_CLIENT, instance);
+    conn->client = sem_open(name, 0);
+    instanceName(name, SEM_LOCKED, instance);
+    conn->locked = sem_open(name, 0);
+
+    if (conn->client == SEM_FAILED || conn->locked == SEM_FAILED) {
+        connClose(conn);
+        return -1;
+    }
+
+    instanceName(name, SHM_NAME, instance);
+    int fd = shm_open(name, O_RDWR, PERMISSION);
+
+    if (fd == -1) {
+        connClose(conn);
+        return -1;
+    }
+
+    void *mapping = mmap(NULL, sizeof(struct hangmanShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (mapping == MAP_FAILED) {
+        connClose(conn);
+        return -1;
+    }
+
+    conn->shm = (struct hangmanShm *)mapping;
+
+    return 0;
+}
+
+int connOpenSocket(struct hangmanConn *conn, const char *instance) {
+    connReset(conn, TRANSPORT_SOCKET);
+    memset(&conn->local, 0, sizeof(conn->local));
+    instanceName(conn->path, SOCKET_PATH, instance);
+
+    return 0;
+}
+
+void connRoute(char transport, int id, enum hangmanRoute route, char *instance) {
+    struct hangmanRegistry registry;
+
+    instance[0] = '\0';
+
+    if (registryOpen(&registry, 0) == -1) {
+        return;
+    }
+
+    if (registryRoute(&registry, transport, id, route, instance) == -1) {
+        instance[0] = '\0';
+    }
+
+    registryClose(&registry);
+}
+
+/**
+ * Connects the socket of a connection
+ * @param  conn Connection opened with connOpenSocket
+ * @param  id   ID of the client
+ * @return      0 on success, -1 if no server is listening
+ */
+static int connConnect(struct hangmanConn *conn, int id) {
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    (void)strncpy(address.sun_path, conn->path, sizeof(address.sun_path) - 1);
+
+    conn->fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+
+    if (conn->fd == -1) {
+        return -1;
+    }
+
+    while (connect(conn->fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        if (errno != EINTR && errno != EAGAIN) {
+            (void)close(conn->fd);
+            conn->fd = -1;
+            return -1;
+        }
+    }
+
+    conn->slot = 0;
+    conn->id = id;
+    conn->data = &conn->local;
+    conn->reply = &conn->response.reply;
+
+    return 0;
+}
+
+/**
+ * Receives the response of the request in flight from the socket
+ * @param  conn Connection with a connected socket
+ * @return      0 on success, -1 if the server is gone
+ */
+static int connReceive(struct hangmanConn *conn) {
+    ssize_t length;
+
+    while ((length = recv(conn->fd, &conn->response, sizeof(conn->response), 0)) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    if (length < (ssize_t)sizeof(conn->response.reply)) {
+        return -1;
+    }
+
+    if (conn->response.reply.flags & REPLY_WORD) {
+        conn->response.word[MAX_WORD_LENGTH - 1] = '\0';
+        (void)strcpy(conn->local.word, conn->response.word);
+    }
+
+    conn->pending = 0;
+    return 0;
+}
+
+/**
+ * Takes a free slot
+ * @param  conn Attached connection
+ * @param  id   ID of the client
+ * @return      0 on success, -1 if every slot is owned
+ */
+static int connTake(struct hangmanConn *conn, int id) {
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        int expected = SLOT_FREE;
+
+        if (__atomic_compare_exchange_n(&conn->shm->slots[i].owner, &expected, id, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            conn->slot = i;
+            conn->id = id;
+            conn->data = &conn->shm->slots[i].data;
+            conn->reply = &conn->shm->slots[i].compact;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Passes the turn from a ticket to the next one, nothing happens if it was passed already
+ * @param fifo   Admission
+ * @param ticket The ticket being served
+ */
+static void admissionAdvance(struct hangmanAdmission *fifo, uint32_t ticket) {
+    if (__atomic_compare_exchange_n(&fifo->serving, &ticket, ticket + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        uint32_t *turn = &fifo->turn[(ticket + 1) % ADMISSION_TURNS];
+
+        (void)__atomic_add_fetch(turn, 1, __ATOMIC_RELEASE);
+        (void)futexWake(turn, INT_MAX);
+    }
+}
+
+/**
+ * Skips the served ticket if its owner died, or if its owner is unknown for too long
+ * (it died between taking the ticket and registering)
+ * @param fifo    Admission
+ * @param serving The ticket being served
+ * @param stalls  Checks of this ticket so far
+ */
+static void admissionRecover(struct hangmanAdmission *fifo, uint32_t serving, int *stalls) {
+    const struct hangmanTicket *holder = &fifo->holders[serving % ADMISSION_HOLDERS];
+    uint32_t ticket = __atomic_load_n(&holder->ticket, __ATOMIC_ACQUIRE);
+
+    if (ticket == serving ? !processAlive(holder->pid) : ++*stalls >= ADMISSION_STALLS) {
+        admissionAdvance(fifo, serving);
+    }
+}
+
+/**
+ * Waits for the turn of a new ticket, then for a free slot
+ * @param  conn Attached connection
+ * @param  id   ID of the client
+ * @return      0 on success, -1 if the server is gone
+ */
+static int connAdmit(struct hangmanConn *conn, int id) {
+    struct hangmanAdmission *fifo = &conn->shm->fifo;
+    struct timespec near = { 0, ADMISSION_NEAR_NS };
+    struct timespec far = { ADMISSION_FAR_S, 0 };
+    uint32_t ticket;
+
+    do {
+        ticket = __atomic_fetch_add(&fifo->next, 1, __ATOMIC_ACQ_REL);
+
+        struct hangmanTicket *holder = &fifo->holders[ticket % ADMISSION_HOLDERS];
+        holder->pid = id;
+        __atomic_store_n(&holder->ticket, ticket, __ATOMIC_RELEASE);
+
+        uint32_t checked = ticket;
+        int stalls = 0;
+
+        while (1) {
+            uint32_t *turn = &fifo->turn[ticket % ADMISSION_TURNS];
+            uint32_t generation = __atomic_load_n(turn, __ATOMIC_ACQUIRE);
+            uint32_t serving = __atomic_load_n(&fifo->serving, __ATOMIC_ACQUIRE);
+
+            // Ahead of the served ticket by ticket - serving, behind it if it was skipped
+            if ((int32_t)(ticket - serving) <= 0) {
+                break;
+            }
+
+            if (futexWait(turn, generation, ticket - serving < ADMISSION_TURNS ? &near : &far) == -1 && errno == ETIMEDOUT) {
+                if (!processAlive(conn->shm->server)) {
+                    return -1;
+                }
+
+                if (serving != checked) {
+                    checked = serving;
+                    stalls = 0;
+                }
+
+                admissionRecover(fifo, serving, &stalls);
+            }
+        }
+    } while (__atomic_load_n(&fifo->serving, __ATOMIC_ACQUIRE) != ticket);     // Skipped, take a new ticket
+
+    // Only the served ticket looks for a slot, the others keep their order. Slots of dead
+    // clients are freed by the server
+    while (1) {
+        uint32_t released = __atomic_load_n(&fifo->released, __ATOMIC_ACQUIRE);
+
+        if (connTake(conn, id) == 0) {
+            break;
+        }
+
+        if (futexWait(&fifo->released, released, &near) == -1 && errno == ETIMEDOUT && !processAlive(conn->shm->server)) {
+            admissionAdvance(fifo, ticket);
+            return -1;
+        }
+    }
+
+    admissionAdvance(fifo, ticket);
+
+    return 0;
+}
+
+int connClaim(struct hangmanConn *conn, int id) {
+    if (conn->transport == TRANSPORT_SOCKET) {
+        return connConnect(conn, id);
+    }
+
+    if (conn->shm->admission == ADMISSION_FIFO) {
+        return connAdmit(conn, id);
+    }
+
+    while (sem_wait(conn->locked) < 0) {     // Wait until a slot is free
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    if (connTake(conn, id) == 0) {
+        return 0;
+    }
+
+    (void)sem_post(conn->locked);
+    return -1;
+}
+
+int connSubmit(struct hangmanConn *conn) {
+    conn->pending = 1;
+
+    if (conn->transport == TRANSPORT_SOCKET) {
+        struct hangmanRequest request;
+
+        request.id = conn->data->id;
+        request.send = conn->data->send;
+        request.signal = (char)conn->data->signal;
+        request.batch = (uint8_t)(conn->data->batch < MAX_BATCH ? conn->data->batch : MAX_BATCH);
+        request.band = (uint8_t)conn->data->band;
+        request.player = conn->data->player;
+        (void)memcpy(request.letters, conn->data->letters, request.batch);
+
+        while (send(conn->fd, &request, offsetof(struct hangmanRequest, letters) + request.batch, MSG_NOSIGNAL) < 0) {
+            if (errno != EINTR) {
+                conn->pending = 0;
+                return -1;
+            }
+        }
+
+        return connReceive(conn);
+    }
+
+    pendingPush(conn->shm, conn->slot);
+
+    // Ring the doorbell of the server
+    if ((conn->shm->wait == WAIT_FUTEX ? eventPost(&conn->shm->doorbell) : sem_post(conn->client)) < 0) {
+        return -1;
+    }
+
+    return connFinish(conn);     // Wait for answer from server
+}
+
+int connFinish(struct hangmanConn *conn) {
+    if (!conn->pending) {
+        return 0;
+    }
+
+    if (conn->transport == TRANSPORT_SOCKET) {
+        return connReceive(conn);
+    }
+
+    struct hangmanSlot *slot = &conn->shm->slots[conn->slot];
+    struct timespec timeout = { CONN_TIMEOUT_S, 0 };
+
+    while (1) {
+        int result;
+
+        if (conn->shm->wait == WAIT_FUTEX) {
+            result = eventWait(&slot->replied, &conn->spin, conn->shm->spin, &timeout);
+        } else {
+            struct timespec deadline;
+
+            (void)clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += CONN_TIMEOUT_S;
+            result = semWaitUntil(&slot->reply, &deadline);
+        }
+
+        if (result == 0) {
+            break;
+        }
+
+        // A server that died never answers
+        if (errno == ETIMEDOUT ? !processAlive(conn->shm->server) : errno != EINTR) {
+            return -1;
+        }
+    }
+
+    conn->pending = 0;
+    return 0;
+}
+
+void connApply(const struct hangmanConn *conn, struct hangmanData *view) {
+    const struct hangmanReply *reply = conn->reply;
+
+    view->status = reply->status;
+    view->clientW = reply->clientW;
+    view->clientL = reply->clientL;
+    view->wrongGuesses = reply->wrongGuesses;
+    view->index = reply->index;
+    view->guessedMask = reply->guessedMask;
+
+    for (int i = 0; i < 26; i++) {
+        view->guessed[i] = (reply->guessedMask & (1u << i)) ? (char)('A' + i) : '_';
+    }
+
+    if (reply->flags & REPLY_NEW) {
+        memset(view->word, 0, sizeof(view->word));
+        memset(view->word, '_', reply->length);
+    }
+
+    if (reply->flags & REPLY_WORD) {
+        (void)strcpy(view->word, conn->data->word);
+    } else {
+        for (uint32_t hits = reply->revealed; hits != 0; hits &= hits - 1) {
+            view->word[__builtin_ctz(hits)] = view->send;
+        }
+    }
+
+    if (reply->message == MESSAGE_HINT) {
+        (void)sprintf(view->info, "%s %c", hangmanMessages[MESSAGE_HINT], reply->hint);
+    } else {
+        (void)strcpy(view->info, reply->message != MESSAGE_NONE ? hangmanMessages[reply->message] : failureDrawing[reply->wrongGuesses]);
+    }
+}
+
+void connRelease(struct hangmanConn *conn) {
+    if (conn->fd != -1) {
+        (void)close(conn->fd);
+        conn->fd = -1;
+        conn->slot = -1;
+        conn->data = NULL;
+        conn->reply = NULL;
+    } else if (conn->slot != -1) {
+        __atomic_store_n(&conn->shm->slots[conn->slot].owner, SLOT_FREE, __ATOMIC_RELEASE);
+
+        if (conn->shm->admission == ADMISSION_FIFO) {
+            (void)__atomic_add_fetch(&conn->shm->fifo.released, 1, __ATOMIC_RELEASE);
+            (void)futexWake(&conn->shm->fifo.released, 1);
+        } else {
+            (void)sem_post(conn->locked);
+        }
+
+        conn->slot = -1;
+        conn->data = NULL;
+        conn->reply = NULL;
+    }
+}
+
+void connClose(struct hangmanConn *conn) {
+    connRelease(conn);
+
+    if (conn->shm != NULL) {
+        (void)munmap(conn->shm, sizeof(struct hangmanShm));
+        conn->shm = NULL;
+    }
+
+    if (conn->client != NULL && conn->client != SEM_FAILED) {
+        (void)sem_close(conn->client);
+    }
+
+    if (conn->locked != NULL && conn->locked != SEM_FAILED) {
+        (void)sem_close(conn->locked);
+    }
+
+    conn->client = NULL;
+    conn->locked = NULL;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file hangman-conn.h
+ * @brief Client side of the shared memory protocol, used by every program talking to hangman-server
+ */
+#ifndef HANGMAN_CONN_H
+#define HANGMAN_CONN_H
+
+#include "hangman-proto.h"
+#include "hangman-registry.h"
+
+struct hangmanConn {
+    char transport; // TRANSPORT_SHM or TRANSPORT_SOCKET
+    struct hangmanShm *shm;
+    sem_t *client; // Doorbell of the server
+    sem_t *locked; // Admission
+    int fd; // Connected socket, -1 if none
+    int slot; // Claimed slot, -1 if none (a connected socket uses 0)
+    int id;
+    short pending; // 1 while a request is in flight
+    unsigned int spin; // Spin history for WAIT_FUTEX
+    struct hangmanData *data; // Data of the claimed slot, or of the socket connection
+    struct hangmanReply *reply; // Compact response of the claimed slot, or of the socket connection
+    struct hangmanData local; // Request and word of the socket connection
+    struct hangmanResponse response; // Last packet received from the socket
+    char path[NAME_LENGTH]; // Socket of the instance
+};
+
+/**
+ * Attaches to a running server over shared memory
+ * @param  conn     Connection to initialize
+ * @param  instance Name of the server instance, "" for the unnamed one
+ * @return          0 on success, -1 if no server is running
+ */
+int connOpen(struct hangmanConn *conn, const char *instance);
+
+/**
+ * Prepares a connection to a server started with the socket transport, the socket itself
+ * is connected by connClaim
+ * @param  conn     Connection to initialize
+ * @param  instance Name of the server instance, "" for the unnamed one
+ * @return          0 on success
+ */
+int connOpenSocket(struct hangmanConn *conn, const char *instance);
+
+/**
+ * Picks the server instance for a client from the registry
+ * @param  transport TRANSPORT_SHM or TRANSPORT_SOCKET
+ * @param  id        ID of the client, usually the pid
+ * @param  route     ROUTE_HASH or ROUTE_LOAD
+ * @param  instance  Receives the instance name, INSTANCE_LENGTH bytes, "" if no instance is
+ *                   registered so the unnamed server is used as before
+ */
+void connRoute(char transport, int id, enum hangmanRoute route, char *instance);
+
+/**
+ * Waits for a free slot and claims it, or connects the socket
+ * @param  conn Attached connection
+ * @param  id   ID of the client, usually the pid
+ * @return      0 on success, -1 on an error
+ */
+int connClaim(struct hangmanConn *conn, int id);
+
+/**
+ * Sends the request in conn->data to the server and waits for the response
+ * @param  conn Connection with a claimed slot
+ * @return      0 on success, -1 on an error
+ */
+int connSubmit(struct hangmanConn *conn);
+
+/**
+ * Waits for the response of a request in flight, used when a signal interrupted connSubmit
+ * @param  conn Connection with a claimed slot
+ * @return      0 on success, -1 on an error
+ */
+int connFinish(struct hangmanConn *conn);
+
+/**
+ * Applies the compact response of the last request to a local copy of the game state,
+ * afterwards the copy looks like a FORMAT_FULL response
+ * @param conn Connection with a claimed slot
+ * @param view Local state, its send field must hold the letter of the last request
+ */
+void connApply(const struct hangmanConn *conn, struct hangmanData *view);
+
+/**
+ * Gives the slot back, the next client waiting for admission may claim it. A socket is closed
+ * @param conn Connection with a claimed slot
+ */
+void connRelease(struct hangmanConn *conn);
+
+/**
+ * Releases the slot if one is claimed and detaches from the server
+ * @param conn Connection
+ */
+void connClose(struct hangmanConn *conn);
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file hangman-dict.c
+ * @brief Reloadable word stores of hangman-server
+ */
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "hangman-dict.h"
+
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5 // Linux, only hidden by the feature test macros
+#endif
+
+#define LOADER_NICE 19 // Where SCHED_IDLE is not available
+
+/**
+ * Allocates an empty store
+ * @param  generation Generation of the store
+ * @return            The store with one reference, NULL if out of memory
+ */
+static struct hangmanDict *dictCreate(uint32_t generation) {
+    struct hangmanDict *dict = (struct hangmanDict *)malloc(sizeof(struct hangmanDict));
+
+    if (dict != NULL) {
+        wordsInit(&dict->words);
+        memset(&dict->index, 0, sizeof(dict->index));
+        memset(&dict->solver, 0, sizeof(dict->solver));
+        dict->refs = 1;
+        dict->generation = generation;
+        dict->next = NULL;
+    }
+
+    return dict;
+}
+
+/**
+ * Frees a store
+ * @param dict Store without references
+ */
+static void dictDestroy(struct hangmanDict *dict) {
+    indexFree(&dict->index);
+    solverFree(&dict->solver);
+    wordsFree(&dict->words);
+    free(dict);
+}
+
+/**
+ * Loads a word list or compiled dictionary
+ * @param  words Empty word store
+ * @param  path  Path of the file
+ * @return       0 on success, -1 if the file can not be read
+ */
+static int dictLoad(struct hangmanWords *words, const char *path) {
+    FILE *file = fopen(path, "r");
+    int result;
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    if (wordsIsCompiled(file)) {
+        result = wordsMap(words, path);
+    } else {
+        result = wordsRead(words, file);
+    }
+
+    (void)fclose(file);
+
+    return result;
+}
+
+/**
+ * Builds the next generation and publishes it
+ * @param dicts Stores
+ */
+static void dictSwap(struct hangmanDicts *dicts) {
+    struct timespec start, end;
+
+    if (dicts->path == NULL) {
+        (void)printf("Reload ignored, the words were read from stdin\n");
+        return;
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    struct hangmanDict *old = dicts->current;
+    struct hangmanDict *dict = dictCreate(old->generation + 1);
+
+    if (dict == NULL || dictLoad(&dict->words, dicts->path) == -1 || dict->words.count == 0 ||
+        dictBuild(dicts, dict) == -1) {
+        (void)printf("Reload of %s failed, keeping generation %u\n", dicts->path, old->generation);
+
+        if (dict != NULL) {
+            dictDestroy(dict);
+        }
+
+        return;
+    }
+
+    // New games take the new store, games in progress keep the old one
+    (void)pthread_mutex_lock(&dicts->lock);
+    __atomic_store_n(&dicts->current, dict, __ATOMIC_RELEASE);
+    (void)pthread_mutex_unlock(&dicts->lock);
+
+    old->next = dicts->retired;
+    dicts->retired = old;
+    dictRelease(dicts, old);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    (void)printf("Reloaded %zu words in %.1f ms (generation %u)\n", dict->words.count,
+                 (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6, dict->generation);
+    (void)fflush(stdout);
+}
+
+/**
+ * Loader thread, reloads on request and frees replaced stores nobody references any longer
+ * @param  arg The stores
+ * @return     NULL once dictsFree stops it
+ */
+static void *load(void *arg) {
+    struct hangmanDicts *dicts = (struct hangmanDicts *)arg;
+    unsigned int spin = 0; // Reloads are rare, the loader sleeps right away
+
+#ifdef __linux__
+    struct sched_param param = { 0 };
+    pid_t thread = (pid_t)syscall(SYS_gettid);
+
+    // The loader only gets CPU time the request threads leave, a reload must not delay them
+    if (syscall(SYS_sched_setscheduler, thread, SCHED_IDLE, &param) == -1) {
+        (void)setpriority(PRIO_PROCESS, (id_t)thread, LOADER_NICE);
+    }
+#endif
+
+    while (1) {
+        if (eventWait(&dicts->wake, &spin, 0, NULL) < 0) {
+            continue;
+        }
+
+        // dictsFree frees the retired stores itself
+        if (__atomic_load_n(&dicts->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        if (__atomic_exchange_n(&dicts->reload, 0, __ATOMIC_ACQUIRE)) {
+            dictSwap(dicts);
+        }
+
+        for (struct hangmanDict **link = &dicts->retired; *link != NULL;) {
+            struct hangmanDict *dict = *link;
+
+            // A retired store can not gain references once it has none
+            if (__atomic_load_n(&dict->refs, __ATOMIC_ACQUIRE) == 0) {
+                *link = dict->next;
+                dictDestroy(dict);
+            } else {
+                link = &dict->next;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int dictsInit(struct hangmanDicts *dicts, const char *path) {
+    dicts->path = path;
+    dicts->reload = 0;
+    dicts->stop = 0;
+    dicts->running = 0;
+    dicts->hints = 0;
+    dicts->retired = NULL;
+    dicts->current = dictCreate(0);
+
+    if (dicts->current == NULL) {
+        return -1;
+    }
+
+    eventInit(&dicts->wake);
+
+    if (pthread_mutex_init(&dicts->lock, NULL) != 0) {
+        dictDestroy(dicts->current);
+        dicts->current = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int dictBuild(const struct hangmanDicts *dicts, struct hangmanDict *dict) {
+    // A compiled dictionary brings its index, a damaged one is rebuilt
+    if (indexMap(&dict->index, &dict->words) == -1 && indexBuild(&dict->index, &dict->words) == -1) {
+        return -1;
+    }
+
+    return dicts->hints ? solverBuild(&dict->solver, &dict->words) : 0;
+}
+
+int dictsStart(struct hangmanDicts *dicts) {
+    if (pthread_create(&dicts->loader, NULL, load, dicts) != 0) {
+        return -1;
+    }
+
+    dicts->running = 1;
+
+    return 0;
+}
+
+void dictsReload(struct hangmanDicts *dicts) {
+    __atomic_store_n(&dicts->reload, 1, __ATOMIC_RELEASE);
+    (void)eventPost(&dicts->wake);
+}
+
+void dictsFree(struct hangmanDicts *dicts) {
+    // A reload in progress finishes first, then the loader sees the flag
+    if (dicts->running) {
+        __atomic_store_n(&dicts->stop, 1, __ATOMIC_RELEASE);
+        (void)eventPost(&dicts->wake);
+        (void)pthread_join(dicts->loader, NULL);
+        dicts->running = 0;
+    }
+
+    while (dicts->retired != NULL) {
+        struct hangmanDict *dict = dicts->retired;
+
+        dicts->retired = dict->next;
+        dictDestroy(dict);
+    }
+
+    if (dicts->current != NULL) {
+        dictDestroy(dicts->current);
+        dicts->current = NULL;
+    }
+}
+
+struct hangmanDict *dictLatest(struct hangmanDicts *dicts, struct hangmanDict *cached) {
+    struct hangmanDict *current = __atomic_load_n(&dicts->current, __ATOMIC_ACQUIRE);
+
+    if (current == cached) {
+        return cached;
+    }
+
+    // The loader can not drop the published reference in between
+    (void)pthread_mutex_lock(&dicts->lock);
+    current = dicts->current;
+    dictRetain(current);
+    (void)pthread_mutex_unlock(&dicts->lock);
+
+    dictRelease(dicts, cached);
+
+    return current;
+}
+
+void dictRelease(struct hangmanDicts *dicts, struct hangmanDict *dict) {
+    if (dict != NULL && __atomic_sub_fetch(&dict->refs, 1, __ATOMIC_RELEASE) == 0) {
+        (void)eventPost(&dicts->wake);
+    }
+}
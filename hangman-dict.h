@@ -0,0 +1,103 @@
+/**
+ * @file hangman-dict.h
+ * @brief Reloadable word stores of hangman-server. A loader thread builds a new store off the
+ *        serving path and publishes it with a single pointer swap, sessions keep the store of
+ *        their current game referenced and a store is freed once the last reference is gone
+ */
+#ifndef HANGMAN_DICT_H
+#define HANGMAN_DICT_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "hangman-futex.h"
+#include "hangman-select.h"
+#include "hangman-solver.h"
+#include "hangman-words.h"
+
+/**
+ * One generation of the word store
+ */
+struct hangmanDict {
+    struct hangmanWords words;
+    struct hangmanIndex index; // Built once the words are loaded, mapped from a compiled dictionary
+    struct hangmanSolver solver; // Built with the index if hints are enabled, empty otherwise
+    uint32_t refs; // Sessions and games using the store, plus one while it is published
+    uint32_t generation; // 0 for the store loaded at startup
+    struct hangmanDict *next; // Next retired store (loader)
+};
+
+struct hangmanDicts {
+    struct hangmanDict *current; // Published store, swapped by the loader
+    pthread_mutex_t lock; // Held while taking a reference to current and while swapping it
+    struct hangmanEvent wake; // Posted to reload and whenever a store loses its last reference
+    int reload; // Set by dictsReload
+    int stop; // Set by dictsFree, the loader returns
+    int running; // The loader thread was started
+    int hints; // Every store gets a solver
+    const char *path; // Word list or compiled dictionary, NULL if read from stdin
+    struct hangmanDict *retired; // Replaced stores that are still referenced (loader)
+    pthread_t loader;
+};
+
+/**
+ * Prepares the stores with an empty first generation, fill dicts->current->words and call
+ * dictBuild afterwards
+ * @param  dicts Stores to initialize
+ * @param  path  File to load on a reload, NULL if there is none
+ * @return       0 on success, -1 if out of memory
+ */
+int dictsInit(struct hangmanDicts *dicts, const char *path);
+
+/**
+ * Builds the index of a loaded store, or maps the one of a compiled dictionary, and its solver
+ * if hints are enabled
+ * @param  dicts Stores
+ * @param  dict  Store with its words loaded
+ * @return       0 on success, -1 if out of memory
+ */
+int dictBuild(const struct hangmanDicts *dicts, struct hangmanDict *dict);
+
+/**
+ * Starts the loader thread, the caller should block the signals the thread must not handle
+ * @param  dicts Stores
+ * @return       0 on success, -1 if the thread can not be started
+ */
+int dictsStart(struct hangmanDicts *dicts);
+
+/**
+ * Asks the loader to load the file again, async-signal-safe
+ * @param dicts Stores
+ */
+void dictsReload(struct hangmanDicts *dicts);
+
+/**
+ * Stops and joins the loader, then frees every store. No other thread may use them any longer
+ * @param dicts Stores
+ */
+void dictsFree(struct hangmanDicts *dicts);
+
+/**
+ * Returns the published store, lock-free unless a newer store was published since the last call
+ * @param  dicts  Stores
+ * @param  cached Referenced store of the caller, NULL if it holds none
+ * @return        The published store, referenced in place of cached
+ */
+struct hangmanDict *dictLatest(struct hangmanDicts *dicts, struct hangmanDict *cached);
+
+/**
+ * Adds a reference to a store the caller already references
+ * @param dict Store
+ */
+static inline void dictRetain(struct hangmanDict *dict) {
+    (void)__atomic_add_fetch(&dict->refs, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Drops a reference, the loader frees a replaced store after its last reference
+ * @param dicts Stores
+ * @param dict  Store, may be NULL
+ */
+void dictRelease(struct hangmanDicts *dicts, struct hangmanDict *dict);
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file hangman-futex.h
+ * @brief Counting event on a futex word in shared memory, waiters spin for a bounded and
+ *        adaptive number of iterations before they sleep in the kernel. Futexes are Linux only,
+ *        elsewhere a sleeping waiter polls the word
+ */
+#ifndef HANGMAN_FUTEX_H
+#define HANGMAN_FUTEX_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SPIN_MIN       16 // Budget of a waiter without history
+#define FUTEX_POLL_MIN 10000 // ns between the first two looks at the word without futexes
+#define FUTEX_POLL_MAX 1000000 // ns between two looks once the wait is long
+
+/**
+ * Wakeup counter shared between processes, posts are never lost
+ */
+struct hangmanEvent {
+    uint32_t count; // Pending posts, also the futex word
+    uint32_t sleepers; // Waiters inside futex wait, posts skip the syscall if 0
+};
+
+/**
+ * Sleeps while a futex word holds a value
+ * @param  word    Futex word
+ * @param  value   Expected value, returns right away if the word differs
+ * @param  timeout Relative timeout, NULL to wait forever
+ * @return         0 when woken, -1 on an error (EAGAIN if the word differed, ETIMEDOUT, EINTR)
+ */
+static inline int futexWait(uint32_t *word, uint32_t value, const struct timespec *timeout) {
+#ifdef __linux__
+    return syscall(SYS_futex, word, FUTEX_WAIT, value, timeout, NULL, 0) < 0 ? -1 : 0;
+#else
+    struct timespec interval = { 0, FUTEX_POLL_MIN };
+    uint64_t left = timeout != NULL ? (uint64_t)timeout->tv_sec * 1000000000u + (uint64_t)timeout->tv_nsec : UINT64_MAX;
+
+    if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != value) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    // Polls quickly at first and backs off, a long wait costs a wakeup per FUTEX_POLL_MAX
+    while (__atomic_load_n(word, __ATOMIC_ACQUIRE) == value) {
+        if (left == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+
+        if ((uint64_t)interval.tv_nsec > left) {
+            interval.tv_nsec = (long)left;
+        }
+
+        if (nanosleep(&interval, NULL) == -1) {
+            return -1;
+        }
+
+        if (left != UINT64_MAX) {
+            left -= (uint64_t)interval.tv_nsec;
+        }
+
+        if (interval.tv_nsec < FUTEX_POLL_MAX / 2) {
+            interval.tv_nsec *= 2;
+        }
+    }
+
+    return 0;
+#endif
+}
+
+/**
+ * Wakes waiters of a futex word
+ * @param  word  Futex word
+ * @param  count Maximum number of waiters to wake
+ * @return       0 on success, -1 on an error
+ */
+static inline int futexWake(uint32_t *word, int count) {
+#ifdef __linux__
+    return syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0) < 0 ? -1 : 0;
+#else
+    // Polling waiters see the word change by themselves
+    (void)word;
+    (void)count;
+
+    return 0;
+#endif
+}
+
+/**
+ * Prepares an event without pending posts
+ * @param event Event to initialize
+ */
+static inline void eventInit(struct hangmanEvent *event) {
+    event->count = 0;
+    event->sleepers = 0;
+}
+
+/**
+ * Tells the CPU that this is a spin loop
+ */
+static inline void eventPause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * Takes one pending post
+ * @param  event Event
+ * @return       1 if a post was taken, 0 if none is pending
+ */
+static inline int eventTry(struct hangmanEvent *event) {
+    uint32_t count = __atomic_load_n(&event->count, __ATOMIC_RELAXED);
+
+    while (count > 0) {
+        if (__atomic_compare_exchange_n(&event->count, &count, count - 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Adds a post and wakes one sleeping waiter
+ * @param  event Event
+ * @return       0 on success, -1 on an error
+ */
+static inline int eventPost(struct hangmanEvent *event) {
+    (void)__atomic_add_fetch(&event->count, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&event->sleepers, __ATOMIC_SEQ_CST) == 0) {
+        return 0;
+    }
+
+    return futexWake(&event->count, 1);
+}
+
+/**
+ * Waits for a post. Spins first, the budget follows how long recent waits took: it moves
+ * towards twice the iterations of waits that ended while spinning and is halved by waits
+ * that had to sleep
+ * @param  event    Event
+ * @param  estimate Spin history of this waiter, 0 at first
+ * @param  limit    Maximum spin iterations, 0 to sleep right away
+ * @param  timeout  Relative timeout of the sleep, NULL to wait forever
+ * @return          0 once a post was taken, -1 on an error (EINTR if a signal arrived, ETIMEDOUT)
+ */
+static inline int eventWait(struct hangmanEvent *event, unsigned int *estimate, unsigned int limit, const struct timespec *timeout) {
+    unsigned int budget = 2 * *estimate + SPIN_MIN;
+
+    if (budget > limit) {
+        budget = limit;
+    }
+
+    for (unsigned int i = 0; i < budget; i++) {
+        if (eventTry(event)) {
+            *estimate += ((int)i - (int)*estimate) / 8;
+            return 0;
+        }
+
+        eventPause();
+    }
+
+    *estimate /= 2;
+
+    while (!eventTry(event)) {
+        (void)__atomic_add_fetch(&event->sleepers, 1, __ATOMIC_SEQ_CST);
+
+        // Sleeps only if no post arrived since the check, the kernel compares the word
+        int result = futexWait(&event->count, 0, timeout);
+        int error = errno;
+
+        (void)__atomic_sub_fetch(&event->sleepers, 1, __ATOMIC_SEQ_CST);
+
+        if (result < 0 && error != EAGAIN) {
+            errno = error;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+#endif
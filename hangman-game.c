@@ -0,0 +1,761 @@
+/**
+ * @file hangman-game.c
+ * @brief Game logic of hangman-server, independent of the transport
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hangman-game.h"
+#include "hangman-log.h"
+#include "hangman-trace.h"
+
+/**
+ * State of one tick of the idle timers
+ */
+struct hangmanSweep {
+    struct hangmanGame *game;
+    unsigned int checks; // Liveness checks done so far
+};
+
+/**
+ * Counts a served request
+ * @param game  Game
+ * @param kind  Kind of the request
+ * @param start Time the request was taken, from metricsNow
+ */
+static void measure(struct hangmanGame *game, int kind, uint64_t start) {
+    struct hangmanShardMetrics *metrics = game->metrics;
+
+    metricAdd(&metrics->requests, 1);
+    metricAdd(&metrics->service[kind][histBucket(metricsNow() - start)], 1);
+}
+
+/**
+ * Current tick of the idle timers
+ * @return Seconds of the monotonic clock
+ */
+static uint32_t tickNow(void) {
+    return (uint32_t)(metricsNow() / 1000000000u);
+}
+
+/**
+ * Seconds until an idle session is looked at again
+ * @param  game Game
+ * @return      The timeout or the liveness interval, whichever is shorter
+ */
+static uint32_t checkInterval(const struct hangmanGame *game) {
+    return game->timeout != 0 && game->timeout < LIVENESS_INTERVAL ? game->timeout : LIVENESS_INTERVAL;
+}
+
+int gameInit(struct hangmanGame *game, struct hangmanDicts *dicts, size_t maxSessions) {
+    game->dicts = dicts;
+    game->metrics = NULL;
+    game->players = NULL;
+    game->room = NULL;
+    game->timeout = 0;
+    game->policy = SELECT_ORDER;
+    game->random = (metricsNow() ^ (uint64_t)(uintptr_t)game) | 1;
+
+    if (poolInit(&game->pool, maxSessions) == -1) {
+        return -1;
+    }
+
+    game->dict = (struct hangmanDict **)calloc(maxSessions, sizeof(struct hangmanDict *));
+    game->seen = (struct hangmanSeen *)calloc(maxSessions, sizeof(struct hangmanSeen));
+    game->player = (struct hangmanPlayer **)calloc(maxSessions, sizeof(struct hangmanPlayer *));
+    game->round = (uint32_t *)calloc(maxSessions, sizeof(uint32_t));
+
+    if (game->dict == NULL || game->seen == NULL || game->player == NULL || game->round == NULL) {
+        free(game->dict);
+        free(game->seen);
+        free(game->player);
+        free(game->round);
+        poolFree(&game->pool);
+        return -1;
+    }
+
+    // Large enough to never grow while serving
+    if (sessionInit(&game->sessions, maxSessions * 2) == -1) {
+        free(game->dict);
+        free(game->seen);
+        free(game->player);
+        free(game->round);
+        poolFree(&game->pool);
+        return -1;
+    }
+
+    if (wheelInit(&game->wheel, maxSessions, tickNow()) == -1) {
+        sessionFree(&game->sessions);
+        free(game->dict);
+        free(game->seen);
+        free(game->player);
+        free(game->round);
+        poolFree(&game->pool);
+        return -1;
+    }
+
+    game->latest = dictLatest(dicts, NULL);
+
+    return 0;
+}
+
+void gameFree(struct hangmanGame *game) {
+    for (size_t i = 0; i < game->pool.capacity; i++) {
+        dictRelease(game->dicts, game->dict[i]);
+    }
+
+    dictRelease(game->dicts, game->latest);
+    free(game->dict);
+    free(game->seen);
+    free(game->player);
+    free(game->round);
+    wheelFree(&game->wheel);
+    sessionFree(&game->sessions);
+    poolFree(&game->pool);
+}
+
+/**
+ * Fired idle timer of a session, expires the session, checks if its client is alive or waits
+ * for the next check
+ * @param argument The sweep of the current tick
+ * @param index    Index of the session record in the pool
+ */
+static void expire(void *argument, uint32_t index) {
+    struct hangmanSweep *sweep = (struct hangmanSweep *)argument;
+    struct hangmanGame *game = sweep->game;
+    struct hangmanTimer *timer = &game->wheel.timers[index];
+    uint32_t now = game->wheel.now;
+    uint32_t idle = now - timer->active;
+    uint32_t check = checkInterval(game);
+    int id = game->pool.records[index].id;
+
+    if (game->timeout != 0 && idle >= game->timeout) {
+        logWrite(LOG_INFO, LOG_EXPIRED, id, -1, '\0', 0);
+        removeClient(game, id);
+
+        if (game->metrics != NULL) {
+            metricAdd(&game->metrics->expired, 1);
+        }
+
+        return;
+    }
+
+    if (idle < check) {
+        // Active since the timer was scheduled
+        wheelSchedule(&game->wheel, index, timer->active + check);
+        return;
+    }
+
+    if (sweep->checks >= LIVENESS_BATCH) {
+        wheelSchedule(&game->wheel, index, now + 1);
+        return;
+    }
+
+    sweep->checks++;
+    uint64_t started = processStarted(id);
+
+    // The first check takes the start time, addClient keeps the connect path free of syscalls
+    if (started != 0 && timer->started == 0) {
+        timer->started = started;
+    }
+
+    if (started == 0 || started != timer->started) {
+        logWrite(LOG_INFO, LOG_DISCONNECT, id, -1, '\0', 0);
+        removeClient(game, id);
+
+        if (game->metrics != NULL) {
+            metricAdd(&game->metrics->expired, 1);
+        }
+
+        return;
+    }
+
+    if (game->timeout != 0 && timer->active + game->timeout - now < check) {
+        wheelSchedule(&game->wheel, index, timer->active + game->timeout);
+    } else {
+        wheelSchedule(&game->wheel, index, now + check);
+    }
+}
+
+void gameTick(struct hangmanGame *game) {
+    struct hangmanSweep sweep = { game, 0 };
+
+    game->latest = dictLatest(game->dicts, game->latest);
+
+    wheelAdvance(&game->wheel, tickNow(), expire, &sweep);
+}
+
+void gameSignal(const struct hangmanGame *game, int sig) {
+    const struct hangmanSessions *sessions = &game->sessions;
+
+    for (size_t i = 0; i < sessions->capacity; i++) {
+        const struct hangmanData *session = sessions->entries[i];
+
+        if (session != NULL) {
+            uint64_t started = processStarted(session->id);
+
+            uint64_t known = game->wheel.timers[session - game->pool.records].started;
+
+            // A session not checked yet has no start time to compare
+            if (started != 0 && (known == 0 || started == known)) {
+                (void)kill(session->id, sig);
+            }
+        }
+    }
+}
+
+int calcClients(const struct hangmanGame *game) {
+    return (int)__atomic_load_n(&game->sessions.count, __ATOMIC_RELAXED);
+}
+
+struct hangmanData *addClient(struct hangmanGame *game, int id) {
+    struct hangmanData *newClient = poolAlloc(&game->pool);
+
+    if (newClient != NULL) {
+        newClient->id = id;
+        newClient->status = 0;
+        newClient->wrongGuesses = 0;
+        newClient->index = -1;
+        newClient->clientW = 0;
+        newClient->clientL = 0;
+        memset(&newClient->word, 0, sizeof(newClient->word));
+        memset(&newClient->guessed, '_', sizeof(newClient->guessed));
+        newClient->guessedMask = 0;
+
+        if (sessionPut(&game->sessions, newClient) == -1) {
+            poolRelease(&game->pool, newClient);
+            return NULL;
+        }
+
+        uint32_t index = (uint32_t)(newClient - game->pool.records);
+        game->seen[index].key = 0;
+        game->player[index] = NULL;
+        game->round[index] = 0;
+        game->latest = dictLatest(game->dicts, game->latest);
+        game->dict[index] = game->latest;
+        dictRetain(game->latest);
+        game->wheel.timers[index].active = game->wheel.now;
+        game->wheel.timers[index].started = 0; // Taken by the first liveness check
+        wheelSchedule(&game->wheel, index, game->wheel.now + checkInterval(game));
+
+        if (game->metrics != NULL) {
+            metricAdd(&game->metrics->connects, 1);
+            metricSet(&game->metrics->sessions, game->sessions.count);
+        }
+
+        return newClient;
+    }
+
+    return NULL;
+}
+
+struct hangmanData *getClient(struct hangmanGame *game, int id) {
+    return sessionGet(&game->sessions, id);
+}
+
+void removeClient(struct hangmanGame *game, int id) {
+    struct hangmanData *removed = sessionRemove(&game->sessions, id);
+
+    if (removed != NULL) {
+        size_t index = (size_t)(removed - game->pool.records);
+
+        wheelCancel(&game->wheel, (uint32_t)index);
+        dictRelease(game->dicts, game->dict[index]);
+        game->dict[index] = NULL;
+        game->player[index] = NULL;
+    }
+
+    if (removed != NULL && game->metrics != NULL) {
+        metricAdd(&game->metrics->disconnects, 1);
+        metricSet(&game->metrics->sessions, game->sessions.count);
+    }
+
+    poolRelease(&game->pool, removed);
+}
+
+uint32_t clearWord(const struct hangmanWords *words, struct hangmanData *client, int index, char letter) {
+    uint32_t revealed = wordPositions(words, index, letter);
+
+    for (uint32_t hits = revealed; hits != 0; hits &= hits - 1) {
+        client->word[__builtin_ctz(hits)] = letter;
+    }
+
+    // Positions beyond the bitmaps only exist in long words
+    for (size_t i = WORDS_POSITIONS; i < words->length[index]; i++) {
+        if (wordAt(words, index)[i] == letter) {
+            client->word[i] = letter;
+            revealed = UINT32_MAX;
+        }
+    }
+
+    return revealed;
+}
+
+/**
+ * Applies one guessed letter to the game of a client
+ * @param  game     Game
+ * @param  words    Word store of the game of the client
+ * @param  client   Client data, in game
+ * @param  letter   The guessed letter
+ * @param  revealed Positions revealed by the letter are added to it
+ * @param  flags    REPLY_WORD is added if the client needs the full word
+ * @return          MESSAGE_NONE if the letter was applied, the reason otherwise
+ */
+static int guessLetter(struct hangmanGame *game, const struct hangmanWords *words, struct hangmanData *client, char letter, uint32_t *revealed, int *flags) {
+    int index = client->index;
+
+    if (letter < 'A' || letter > 'Z') {
+        client->status = 3;
+        return MESSAGE_INVALID_GUESS;
+    }
+
+    int no = (int)letter - 65;
+
+    if (client->guessedMask & (1u << no)) {
+        client->status = 3;
+        return MESSAGE_ALREADY_GUESSED;
+    }
+
+    client->guessed[no] = letter;
+    client->guessedMask |= 1u << no;
+
+    if (words->mask[index] & (1u << no)) {
+        uint32_t hits = clearWord(words, client, index, letter);
+
+        if (hits == UINT32_MAX) {
+            *flags |= REPLY_WORD;
+        }
+
+        *revealed |= hits;
+    } else {
+        client->wrongGuesses++;
+    }
+
+    client->status = 2;
+
+    if (client->wrongGuesses == 9) {
+        client->status = 0;
+        client->clientL++;
+        (void)strcpy(client->word, wordAt(words, index));
+        *flags |= REPLY_WORD;
+
+        if (game->metrics != NULL) {
+            metricAdd(&game->metrics->lost, 1);
+        }
+    } else if ((words->mask[index] & ~client->guessedMask) == 0) {
+        client->status = 0;
+        client->clientW++;
+
+        if (game->metrics != NULL) {
+            metricAdd(&game->metrics->won, 1);
+        }
+    }
+
+    return MESSAGE_NONE;
+}
+
+int roomInit(struct hangmanRoom *room, struct hangmanRoomShm *shm) {
+    if (pthread_mutex_init(&room->lock, NULL) != 0) {
+        return -1;
+    }
+
+    memset(&room->data, 0, sizeof(room->data));
+    memset(&room->data.guessed, '_', sizeof(room->data.guessed));
+    room->data.index = -1;
+    memset(&room->state, 0, sizeof(room->state));
+    memset(&room->seen, 0, sizeof(room->seen));
+    room->shm = shm;
+    room->dict = NULL;
+    room->random = (metricsNow() ^ (uint64_t)(uintptr_t)room) | 1;
+
+    roomPublish(shm, &room->state);
+
+    return 0;
+}
+
+void roomFree(struct hangmanRoom *room, struct hangmanDicts *dicts) {
+    dictRelease(dicts, room->dict);
+    room->dict = NULL;
+    (void)pthread_mutex_destroy(&room->lock);
+}
+
+/**
+ * Publishes the game of the room, called with the lock of the room held
+ * @param room Room
+ */
+static void roomUpdate(struct hangmanRoom *room) {
+    struct hangmanRoomState *state = &room->state;
+    const struct hangmanData *data = &room->data;
+
+    state->index = data->index;
+    state->guessedMask = data->guessedMask;
+    state->status = data->status;
+    state->wrongGuesses = data->wrongGuesses;
+    (void)memcpy(state->word, data->word, sizeof(state->word));
+
+    roomPublish(room->shm, state);
+}
+
+/**
+ * Starts the next round of the room with a word of the newest store, called with the lock of the room held
+ * @param  game Game of the client that starts the round
+ * @return      MESSAGE_NONE on success, MESSAGE_NO_MORE_WORDS if the store has no word left
+ */
+static int roomStart(struct hangmanGame *game) {
+    struct hangmanRoom *room = game->room;
+    struct hangmanData *data = &room->data;
+
+    room->dict = dictLatest(game->dicts, room->dict);
+
+    const struct hangmanDict *dict = room->dict;
+    const struct hangmanWords *words = &dict->words;
+
+    if (game->policy == SELECT_ORDER) {
+        data->index++;
+    } else {
+        data->index = selectWord(&dict->index, game->policy, 0, dict->generation, &room->seen, &room->random);
+    }
+
+    if (data->index < 0 || data->index >= (int)words->count || !wordValid(words, (size_t)data->index)) {
+        return MESSAGE_NO_MORE_WORDS;
+    }
+
+    memset(&data->word, 0, MAX_WORD_LENGTH);
+    memset(&data->word, '_', words->length[data->index]);
+    data->wrongGuesses = 0;
+    memset(&data->guessed, '_', 26);
+    data->guessedMask = 0;
+    data->status = 2;
+
+    room->state.round++;
+    room->state.players = 0;
+    room->state.guesses = 0;
+    room->state.last = 0;
+
+    return MESSAGE_NONE;
+}
+
+/**
+ * Brings a client up to date with the room, it joins the current round if it is not in it yet.
+ * Called with the lock of the room held
+ * @param game   Game of the client
+ * @param record Index of the session record of the client in the pool
+ * @param client Client data
+ */
+static void roomJoin(struct hangmanGame *game, size_t record, struct hangmanData *client) {
+    struct hangmanRoom *room = game->room;
+    const struct hangmanData *data = &room->data;
+
+    if (game->round[record] != room->state.round) {
+        game->round[record] = room->state.round;
+        room->state.players++;
+
+        // The store of the round stays referenced while the client is in it
+        if (game->dict[record] != room->dict) {
+            dictRelease(game->dicts, game->dict[record]);
+            game->dict[record] = room->dict;
+            dictRetain(room->dict);
+        }
+    }
+
+    client->status = data->status;
+    client->index = data->index;
+    client->wrongGuesses = data->wrongGuesses;
+    client->guessedMask = data->guessedMask;
+    (void)memcpy(&client->word, &data->word, MAX_WORD_LENGTH);
+    (void)memcpy(&client->guessed, &data->guessed, 26);
+}
+
+/**
+ * Lets a client that answered Y take part in the room. The first client done with a round starts
+ * the next one, the others join the round in progress
+ * @param  game   Game of the client
+ * @param  record Index of the session record of the client in the pool
+ * @param  client Client data
+ * @return        MESSAGE_NONE on success, MESSAGE_NO_MORE_WORDS if the room has no word left
+ */
+static int roomAnswer(struct hangmanGame *game, size_t record, struct hangmanData *client) {
+    struct hangmanRoom *room = game->room;
+    int message = MESSAGE_NONE;
+
+    (void)pthread_mutex_lock(&room->lock);
+
+    if (room->data.status != 2) {
+        message = roomStart(game);
+    }
+
+    if (message == MESSAGE_NONE) {
+        roomJoin(game, record, client);
+        roomUpdate(room);
+    }
+
+    (void)pthread_mutex_unlock(&room->lock);
+
+    return message;
+}
+
+/**
+ * Applies letters of a client to the room in order until one is rejected or the round ends. A client
+ * whose round already ended gets its outcome, or joins the next round if that started meanwhile.
+ * The client whose letter wins or loses the round gets the score
+ * @param  game    Game of the client
+ * @param  record  Index of the session record of the client in the pool
+ * @param  client  Client data, in game
+ * @param  letters Guessed letters
+ * @param  count   Number of letters
+ * @param  applied Receives the number of letters applied
+ * @return         MESSAGE_NONE if no letter was rejected, the reason otherwise
+ */
+static int roomGuess(struct hangmanGame *game, size_t record, struct hangmanData *client, const char *letters, int count, int *applied) {
+    struct hangmanRoom *room = game->room;
+    struct hangmanData *data = &room->data;
+    int message = MESSAGE_NONE;
+    uint32_t revealed = 0;
+    int flags = 0;
+
+    (void)pthread_mutex_lock(&room->lock);
+
+    if (game->round[record] != room->state.round) {
+        roomJoin(game, record, client);
+    }
+
+    while (data->status == 2 && *applied < count) {
+        message = guessLetter(game, &room->dict->words, data, letters[*applied], &revealed, &flags);
+
+        if (message != MESSAGE_NONE) {
+            data->status = 2;
+            break;
+        }
+
+        (*applied)++;
+    }
+
+    if (*applied > 0) {
+        room->state.guesses += (uint32_t)*applied;
+        room->state.last = client->id;
+
+        if (data->status == 0 && data->wrongGuesses == 9) {
+            room->state.lost++;
+            client->clientL++;
+        } else if (data->status == 0) {
+            room->state.won++;
+            client->clientW++;
+        }
+
+        roomUpdate(room);
+    }
+
+    roomJoin(game, record, client);
+
+    if (message != MESSAGE_NONE) {
+        client->status = 3;
+    }
+
+    (void)pthread_mutex_unlock(&room->lock);
+
+    return message;
+}
+
+int handleRequest(struct hangmanGame *game, struct hangmanData *shared, struct hangmanReply *reply) {
+    uint64_t start = game->metrics != NULL ? metricsNow() : 0;
+    int kind = METRIC_ANSWER;
+    int message = MESSAGE_NONE;
+    int flags = 0;
+    uint32_t revealed = 0;
+    int applied = 0;
+    char hint = '\0';
+    int id = shared->id;
+
+    struct hangmanData *clientData = getClient(game, id);
+
+    if (clientData == NULL) {
+        clientData = addClient(game, id);
+        kind = METRIC_CONNECT;
+    }
+
+    if (clientData == NULL) {
+        logWrite(LOG_INFO, LOG_FULL, id, -1, shared->send, 0);
+
+        if (reply != NULL) {
+            memset(reply, 0, sizeof(*reply));
+            reply->status = -1;
+            reply->message = MESSAGE_SERVER_FULL;
+        } else {
+            shared->status = -1;
+            (void)strcpy(shared->info, hangmanMessages[MESSAGE_SERVER_FULL]);
+        }
+
+        traceWrite(shared, NULL);
+
+        if (game->metrics != NULL) {
+            measure(game, kind, start);
+        }
+
+        return -1;
+    }
+
+    size_t record = (size_t)(clientData - game->pool.records);
+    game->wheel.timers[record].active = game->wheel.now;
+
+    if (kind == METRIC_CONNECT && shared->player != 0 && game->players != NULL) {
+        // A full store leaves the player anonymous
+        game->player[record] = playerFind(game->players, shared->player);
+
+        if (game->player[record] != NULL) {
+            playerLoad(game->player[record], &clientData->clientW, &clientData->clientL, &clientData->index);
+        }
+    }
+
+    const struct hangmanWords *words = &game->dict[record]->words;
+
+    if (shared->signal == 0) {
+        logWrite(LOG_DEBUG, LOG_REQUEST, id, clientData->status, shared->send, 0);
+
+        if (clientData->status > 1 && shared->send == '?' && shared->batch == 0) {
+            // Hint, the letter that tells most about the words still matching, empty without a solver
+            const struct hangmanSolver *solver = &game->dict[record]->solver;
+            kind = METRIC_GUESS;
+
+            clientData->status = 2;
+            message = solverRank(solver, clientData->word, clientData->guessedMask, &hint, 1, NULL) == 1 ? MESSAGE_HINT : MESSAGE_NO_HINT;
+        } else if (clientData->status > 1) {
+            // In game
+
+            // A single guess is a batch of one letter
+            const char *letters = shared->batch > 0 ? shared->letters : &shared->send;
+            int count = shared->batch > 0 ? (shared->batch < MAX_BATCH ? shared->batch : MAX_BATCH) : 1;
+            kind = METRIC_GUESS;
+
+            if (game->room != NULL) {
+                // Other players move the word on between requests, the client gets all of it
+                message = roomGuess(game, record, clientData, letters, count, &applied);
+                words = &game->dict[record]->words;
+                flags |= REPLY_WORD;
+            } else {
+                do {
+                    message = guessLetter(game, words, clientData, letters[applied], &revealed, &flags);
+
+                    if (message != MESSAGE_NONE) {
+                        break;
+                    }
+
+                    applied++;
+                } while (applied < count && clientData->status == 2);
+            }
+
+            // The client cannot tell which letter of a batch revealed a position
+            if (shared->batch > 0 && revealed != 0) {
+                flags |= REPLY_WORD;
+            }
+        } else if (clientData->status >= 0) {
+            // Not in game
+
+            if (shared->send == 'Y' && game->room != NULL) {
+                message = roomAnswer(game, record, clientData);
+
+                if (message == MESSAGE_NONE) {
+                    words = &game->dict[record]->words;
+                    flags |= REPLY_NEW | REPLY_WORD;
+                } else {
+                    clientData->status = -1;
+                }
+            } else if (shared->send == 'Y') {
+                game->latest = dictLatest(game->dicts, game->latest);
+
+                // The previous game is over, the next one uses the newest store
+                if (game->dict[record] != game->latest) {
+                    dictRelease(game->dicts, game->dict[record]);
+                    game->dict[record] = game->latest;
+                    dictRetain(game->latest);
+                    words = &game->latest->words;
+                }
+
+                clientData->status = 2;
+
+                if (game->policy == SELECT_ORDER) {
+                    clientData->index++;
+                } else {
+                    const struct hangmanDict *dict = game->dict[record];
+
+                    clientData->index = selectWord(&dict->index, game->policy, shared->band, dict->generation, &game->seen[record], &game->random);
+                }
+
+                if (clientData->index >= 0 && clientData->index < (int)words->count && wordValid(words, (size_t)clientData->index)) {
+                    memset(&clientData->word, 0, MAX_WORD_LENGTH);
+                    memset(&clientData->word, '_', words->length[clientData->index]);
+                    clientData->wrongGuesses = 0;
+                    memset(&clientData->guessed, '_', 26);
+                    clientData->guessedMask = 0;
+                    flags |= REPLY_NEW;
+                } else {
+                    clientData->status = -1;
+                    message = MESSAGE_NO_MORE_WORDS;
+                }
+            } else if (shared->send == 'N') {
+                // N or Invalid input
+                clientData->status = -1;
+                message = MESSAGE_QUIT;
+            } else {
+                clientData->status = 1;
+                message = MESSAGE_INVALID_ANSWER;
+            }
+        }
+    } else {
+        logWrite(LOG_INFO, LOG_DISCONNECT, id, clientData->status, shared->send, 0);
+        kind = METRIC_DISCONNECT;
+
+        clientData->status = -1;
+        message = MESSAGE_CLIENT_SHUTDOWN;
+    }
+
+    if (game->player[record] != NULL) {
+        playerStore(game->player[record], clientData->clientW, clientData->clientL, clientData->index);
+    }
+
+    if (reply != NULL) {
+        reply->status = clientData->status;
+        reply->clientW = clientData->clientW;
+        reply->clientL = clientData->clientL;
+        reply->wrongGuesses = (uint8_t)clientData->wrongGuesses;
+        reply->message = (uint8_t)message;
+        reply->flags = (uint8_t)flags;
+        reply->applied = (uint8_t)applied;
+        reply->hint = (uint8_t)hint;
+        reply->index = clientData->index;
+        reply->guessedMask = clientData->guessedMask;
+        reply->revealed = revealed;
+
+        if (flags & REPLY_NEW) {
+            reply->length = words->length[clientData->index];
+        }
+
+        if (flags & REPLY_WORD) {
+            (void)strcpy(shared->word, clientData->word);
+        }
+    } else {
+        shared->status = clientData->status;
+        shared->wrongGuesses = clientData->wrongGuesses;
+        shared->index = clientData->index;
+        shared->clientW = clientData->clientW;
+        shared->clientL = clientData->clientL;
+        shared->applied = (short)applied;
+        (void)memcpy(shared->guessed, clientData->guessed, sizeof(shared->guessed));
+        shared->guessedMask = clientData->guessedMask;
+        (void)strcpy(shared->word, clientData->word);
+
+        if (message == MESSAGE_HINT) {
+            (void)sprintf(shared->info, "%s %c", hangmanMessages[MESSAGE_HINT], hint);
+        } else {
+            (void)strcpy(shared->info, message != MESSAGE_NONE ? hangmanMessages[message] : failureDrawing[clientData->wrongGuesses]);
+        }
+    }
+
+    traceWrite(shared, clientData);
+
+    if (game->metrics != NULL) {
+        measure(game, kind, start);
+    }
+
+    return clientData->status;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file hangman-game.h
+ * @brief Game logic of hangman-server, one hangmanGame holds the sessions of one shard
+ */
+#ifndef HANGMAN_GAME_H
+#define HANGMAN_GAME_H
+
+#include "hangman-dict.h"
+#include "hangman-metrics.h"
+#include "hangman-players.h"
+#include "hangman-proto.h"
+#include "hangman-room.h"
+#include "hangman-session.h"
+#include "hangman-timer.h"
+
+#define LIVENESS_INTERVAL 30 // Seconds of inactivity before a client is checked for being alive
+#define LIVENESS_BATCH    64 // Liveness checks per tick, the rest waits for the next tick
+
+/**
+ * Word every client of a server in room mode guesses, shared by the games of all shards
+ */
+struct hangmanRoom {
+    pthread_mutex_t lock; // Held while a guess is applied, spectators never take it
+    struct hangmanData data; // Game of the room
+    struct hangmanRoomState state; // Last published state
+    struct hangmanRoomShm *shm; // Page the state is published in
+    struct hangmanDict *dict; // Store of the current round, referenced, NULL before the first round
+    struct hangmanSeen seen; // Words the room already had
+    uint64_t random; // State of the random generator of the word selection
+};
+
+struct hangmanGame {
+    struct hangmanSessions sessions;
+    struct hangmanPool pool;
+    struct hangmanWheel wheel; // Idle timer of every record in the pool, ticks in seconds
+    uint32_t timeout; // Seconds without a request until a session expires, 0 to keep idle sessions
+    int policy; // How new words are selected, SELECT_ORDER by default
+    uint64_t random; // State of the random generator of the word selection
+    struct hangmanSeen *seen; // Words every record in the pool got
+    struct hangmanDicts *dicts; // Word stores, shared between games
+    struct hangmanDict *latest; // Newest store the game has seen, referenced by the game
+    struct hangmanDict **dict; // Store of the current game of every record in the pool, referenced
+    struct hangmanPlayers *players; // Persistent player records, shared between games, NULL if not kept
+    struct hangmanPlayer **player; // Player record of every record in the pool, NULL for anonymous clients
+    struct hangmanShardMetrics *metrics; // Published counters, NULL if not published
+    struct hangmanRoom *room; // Word shared by all clients, NULL unless in room mode
+    uint32_t *round; // Round of the room every record in the pool takes part in, 0 if none
+};
+
+/**
+ * Prepares a game without sessions
+ * @param  game        Game to initialize
+ * @param  dicts       Word stores, shared between games
+ * @param  maxSessions Maximum number of sessions
+ * @return             0 on success, -1 if out of memory
+ */
+int gameInit(struct hangmanGame *game, struct hangmanDicts *dicts, size_t maxSessions);
+
+/**
+ * Frees all sessions of a game
+ * @param game Game
+ */
+void gameFree(struct hangmanGame *game);
+
+/**
+ * Advances the idle timers to the current second. Sessions idle for longer than the timeout
+ * expire, sessions of clients that died or whose pid was reused by another process are removed.
+ * Also lets go of a replaced word store the game no longer needs
+ * @param game Game
+ */
+void gameTick(struct hangmanGame *game);
+
+/**
+ * Sends a signal to every connected client, processes that took over the pid of a client are
+ * spared
+ * @param game Game
+ * @param sig  Signal to send
+ */
+void gameSignal(const struct hangmanGame *game, int sig);
+
+/**
+ * Determines how many clients are connected, may be called from any thread
+ * @param  game Game
+ * @return      Number of clients
+ */
+int calcClients(const struct hangmanGame *game);
+
+/**
+ * Prepares a room and publishes its empty state, the first client to answer Y starts the first round
+ * @param  room Room to initialize
+ * @param  shm  Mapped page of the room
+ * @return      0 on success, -1 if the lock can not be created
+ */
+int roomInit(struct hangmanRoom *room, struct hangmanRoomShm *shm);
+
+/**
+ * Lets go of the store of the current round
+ * @param room  Room
+ * @param dicts Word stores
+ */
+void roomFree(struct hangmanRoom *room, struct hangmanDicts *dicts);
+
+/**
+ * Adds a new Client to the session table
+ * @param  game Game
+ * @param  id   ID of the client
+ * @return      Data of the new client, NULL if the game is full
+ */
+struct hangmanData *addClient(struct hangmanGame *game, int id);
+
+/**
+ * Returns the clients data from the session table
+ * @param  game Game
+ * @param  id   ID obtained by the client
+ * @return      hangmanData for specified ID
+ */
+struct hangmanData *getClient(struct hangmanGame *game, int id);
+
+/**
+ * Removes a client from the session table
+ * @param game Game
+ * @param id   ID from the client
+ */
+void removeClient(struct hangmanGame *game, int id);
+
+/**
+ * Replaces _ from a word at the positions of a correctly guessed letter
+ * @param  words  Word store
+ * @param  client Client data
+ * @param  index  Index of the word the client is guessing
+ * @param  letter The guessed letter
+ * @return        Revealed positions below WORDS_POSITIONS, all bits set if a position beyond was revealed
+ */
+uint32_t clearWord(const struct hangmanWords *words, struct hangmanData *client, int index, char letter);
+
+/**
+ * Handles a request and writes the response, the letters of a batch are guessed in order
+ * until one is rejected or the game is won or lost. A new game takes its word from the
+ * newest word store, chosen by the policy of the game, a game in progress keeps its store.
+ * A named player continues with the score and word index of its record. In room mode the
+ * letters go to the word of the room and the response always carries the whole word
+ * @param  game   Game the client belongs to
+ * @param  shared Request of the client, overwritten by the response if reply is NULL
+ * @param  reply  Compact response, NULL to fill in shared instead (FORMAT_FULL)
+ * @return        Status of the client after the request, -1 if it should be removed
+ */
+int handleRequest(struct hangmanGame *game, struct hangmanData *shared, struct hangmanReply *reply);
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file hangman-hist.h
+ * @brief Log-linear latency histogram, 32 buckets per power of two (about 3% precision)
+ */
+#ifndef HANGMAN_HIST_H
+#define HANGMAN_HIST_H
+
+#include <stdint.h>
+
+#define HIST_SUB        32
+#define HIST_BUCKETS    (60 * HIST_SUB)
+
+/**
+ * Bucket of a value
+ * @param  value Value, usually nanoseconds
+ * @return       Index of the bucket
+ */
+static inline int histBucket(uint64_t value) {
+    if (value < HIST_SUB) {
+        return (int)value;
+    }
+
+    int exponent = 63 - __builtin_clzll(value);
+
+    return (exponent - 4) * HIST_SUB + (int)((value >> (exponent - 5)) & (HIST_SUB - 1));
+}
+
+/**
+ * Smallest value that falls into a bucket
+ * @param  bucket Index of the bucket
+ * @return        Lower bound of the bucket
+ */
+static inline uint64_t histValue(int bucket) {
+    if (bucket < HIST_SUB) {
+        return (uint64_t)bucket;
+    }
+
+    int exponent = bucket / HIST_SUB + 4;
+
+    return (uint64_t)(HIST_SUB + bucket % HIST_SUB) << (exponent - 5);
+}
+
+/**
+ * Value below which a fraction of the recorded values lie
+ * @param  hist     Histogram with HIST_BUCKETS counters
+ * @param  fraction Fraction between 0 and 1, e.g. 0.99
+ * @return          Lower bound of the bucket holding the percentile, 0 if the histogram is empty
+ */
+static inline uint64_t histPercentile(const uint64_t *hist, double fraction) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        total += hist[i];
+    }
+
+    uint64_t rank = (uint64_t)(fraction * total);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist[i];
+
+        if (seen > rank) {
+            return histValue(i);
+        }
+    }
+
+    return 0;
+}
+
+#endif
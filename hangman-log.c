@@ -0,0 +1,117 @@
+/**
+ * @file hangman-log.c
+ * @brief Asynchronous logging of hangman-server
+ */
+#include "hangman-log.h"
+#include "hangman-ring.h"
+
+#define LOG_RING        4096 // Power of two
+#define LOG_INTERVAL    10000000 // ns the background thread sleeps when the ring is empty
+
+struct hangmanLogRecord {
+    short type;
+    short status;
+    int id;
+    int value;
+    char send;
+};
+
+int logLevel = LOG_OFF;
+
+static struct hangmanRing ring;
+static FILE *output;
+
+/**
+ * Formats a record the way the server always printed it
+ * @param ring The log ring
+ * @param data Record to write
+ */
+static void format(struct hangmanRing *ring, void *data) {
+    const struct hangmanLogRecord *record = (const struct hangmanLogRecord *)data;
+
+    (void)ring;
+
+    switch (record->type) {
+        case LOG_WAITING:
+            (void)fprintf(output, "\n\nClients: %i\nWaiting for a client...", record->value);
+            break;
+
+        case LOG_REQUEST:
+            (void)fprintf(output, "Client(%i) [%i - %c]\n", record->id, record->status, record->send);
+            break;
+
+        case LOG_DISCONNECT:
+            (void)fprintf(output, "Client(%i)\nClient disconnected, free resources", record->id);
+            break;
+
+        case LOG_FULL:
+            (void)fprintf(output, "Client(%i)\nServer full", record->id);
+            break;
+
+        case LOG_EXPIRED:
+            (void)fprintf(output, "Client(%i)\nSession idle, free resources", record->id);
+            break;
+    }
+}
+
+/**
+ * Reports dropped records and writes the batch
+ * @param ring  The log ring
+ * @param count Records formatted
+ */
+static void flush(struct hangmanRing *ring, int count) {
+    unsigned long lost = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+
+    if (lost > 0) {
+        (void)fprintf(output, "\n(%lu log records dropped)\n", lost);
+    }
+
+    if (count > 0) {
+        (void)fflush(output);
+    }
+}
+
+int logStart(int level, FILE *out) {
+    output = out;
+
+    if (level == LOG_OFF) {
+        return 0;
+    }
+
+    if (ringInit(&ring, LOG_RING, sizeof(struct hangmanLogRecord), LOG_INTERVAL, format, flush) == -1) {
+        return -1;
+    }
+
+    if (ringStart(&ring) == -1) {
+        ringFree(&ring);
+        return -1;
+    }
+
+    logLevel = level;
+
+    return 0;
+}
+
+void logStop(void) {
+    if (logLevel != LOG_OFF) {
+        logLevel = LOG_OFF;
+        ringStop(&ring);
+        (void)fflush(output);
+    }
+}
+
+void logPush(int type, int id, short status, char send, int value) {
+    unsigned int pos;
+    struct hangmanLogRecord *record = (struct hangmanLogRecord *)ringReserve(&ring, &pos);
+
+    if (record == NULL) {
+        return;
+    }
+
+    record->type = (short)type;
+    record->status = status;
+    record->id = id;
+    record->value = value;
+    record->send = send;
+    ringPublish(&ring, pos);
+}
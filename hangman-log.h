@@ -0,0 +1,69 @@
+/**
+ * @file hangman-log.h
+ * @brief Asynchronous logging of hangman-server. Request threads put fixed-size records into a
+ *        lock-free ring, a background thread formats and writes them in batches. Records are
+ *        dropped instead of blocking when the ring is full
+ */
+#ifndef HANGMAN_LOG_H
+#define HANGMAN_LOG_H
+
+#include <stdio.h>
+
+enum hangmanLogLevel {
+    LOG_OFF,
+    LOG_INFO, // Disconnects, expired sessions and rejected clients
+    LOG_DEBUG // Every request
+};
+
+enum hangmanLogType {
+    LOG_WAITING, // value: number of clients
+    LOG_REQUEST, // id, status, send
+    LOG_DISCONNECT, // id
+    LOG_FULL, // id
+    LOG_EXPIRED // id
+};
+
+/**
+ * Current verbosity, records above it are discarded right away
+ */
+extern int logLevel;
+
+/**
+ * Starts the background thread
+ * @param  level Verbosity, nothing is started for LOG_OFF
+ * @param  out   Destination of the formatted records
+ * @return       0 on success, -1 if the thread can not be started
+ */
+int logStart(int level, FILE *out);
+
+/**
+ * Writes the remaining records and stops the background thread
+ */
+void logStop(void);
+
+/**
+ * Queues a record, never blocks
+ * @param type   Type of the record
+ * @param id     Client ID
+ * @param status Status of the client
+ * @param send   Letter or answer of the client
+ * @param value  Additional value, depends on the type
+ */
+void logPush(int type, int id, short status, char send, int value);
+
+/**
+ * Queues a record if the verbosity includes its level
+ * @param level  Level of the record
+ * @param type   Type of the record
+ * @param id     Client ID
+ * @param status Status of the client
+ * @param send   Letter or answer of the client
+ * @param value  Additional value, depends on the type
+ */
+static inline void logWrite(int level, int type, int id, short status, char send, int value) {
+    if (level <= logLevel) {
+        logPush(type, id, status, send, value);
+    }
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file hangman-metrics.h
+ * @brief Live counters hangman-server publishes in a shared memory segment for hangman-stats.
+ *        Every shard writes only its own block with relaxed atomics, readers sum up the blocks
+ */
+#ifndef HANGMAN_METRICS_H
+#define HANGMAN_METRICS_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "hangman-hist.h"
+
+#define METRICS_NAME    "/hangmanStats"
+#define METRICS_MAGIC   0x4d474e48u // "HNGM"
+
+enum hangmanMetricKind {
+    METRIC_CONNECT, // First request of a client
+    METRIC_ANSWER, // Y/N between games
+    METRIC_GUESS, // Letter during a game
+    METRIC_DISCONNECT, // Client shutdown
+    METRIC_KINDS
+};
+
+/**
+ * Counters of one shard, only written by the thread owning the shard
+ */
+struct hangmanShardMetrics {
+    uint64_t requests;
+    uint64_t won;
+    uint64_t lost;
+    uint64_t connects;
+    uint64_t disconnects;
+    uint64_t expired; // Sessions removed by the idle timers, also counted as disconnects
+    uint64_t sessions; // Currently connected clients
+    uint64_t service[METRIC_KINDS][HIST_BUCKETS]; // Service time in ns
+} __attribute__((aligned(64)));
+
+struct hangmanMetrics {
+    uint32_t magic;
+    uint32_t workers; // Number of shard blocks
+    int64_t started; // Start of the server, seconds since the epoch
+    struct hangmanShardMetrics shard[];
+};
+
+/**
+ * Size of the metrics segment
+ * @param  workers Number of shards
+ * @return         Size in bytes
+ */
+static inline size_t metricsSize(uint32_t workers) {
+    return sizeof(struct hangmanMetrics) + workers * sizeof(struct hangmanShardMetrics);
+}
+
+/**
+ * Adds to a counter of the own shard, a plain load and store since there is only one writer
+ * @param counter Counter
+ * @param n       Increment
+ */
+static inline void metricAdd(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+/**
+ * Sets a gauge of the own shard
+ * @param counter Gauge
+ * @param value   New value
+ */
+static inline void metricSet(uint64_t *counter, uint64_t value) {
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * Reads a counter of any shard
+ * @param  counter Counter
+ * @return         Current value
+ */
+static inline uint64_t metricRead(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static inline uint64_t metricsNow(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif
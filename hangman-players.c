@@ -0,0 +1,293 @@
+/**
+ * @file hangman-players.c
+ * @brief Persistent player records of hangman-server
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "hangman-players.h"
+
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5 // Linux, only hidden by the feature test macros
+#endif
+
+#define SAVER_NICE    19 // Where SCHED_IDLE is not available
+#define PLAYERS_CHUNK 4096 // Records copied per write, runs of free records are left as holes
+
+/**
+ * Writes a whole buffer
+ * @param  fd     File
+ * @param  buffer Data
+ * @param  size   Bytes to write
+ * @return        0 on success, -1 on error
+ */
+static int writeAll(int fd, const void *buffer, size_t size) {
+    const char *next = (const char *)buffer;
+
+    while (size > 0) {
+        ssize_t written = write(fd, next, size);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (written <= 0) {
+            return -1;
+        }
+
+        next += written;
+        size -= (size_t)written;
+    }
+
+    return 0;
+}
+
+/**
+ * Creates an empty player file, its records are a hole until they are used
+ * @param  path Player file
+ * @return      0 on success, -1 on error
+ */
+static int playersCreate(const char *path) {
+    struct hangmanPlayersHeader header;
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    (void)memcpy(header.magic, PLAYERS_MAGIC, sizeof(header.magic));
+    header.version = PLAYERS_VERSION;
+    header.capacity = PLAYERS_CAPACITY;
+    header.saved = (uint64_t)time(NULL);
+
+    if (writeAll(fd, &header, sizeof(header)) == -1 ||
+        ftruncate(fd, (off_t)(sizeof(header) + PLAYERS_CAPACITY * sizeof(struct hangmanPlayer))) == -1) {
+        (void)close(fd);
+        (void)unlink(path);
+        return -1;
+    }
+
+    return close(fd);
+}
+
+int playersOpen(struct hangmanPlayers *players, const char *path, unsigned int interval) {
+    struct stat st;
+
+    memset(players, 0, sizeof(*players));
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1 && errno == ENOENT && playersCreate(path) == 0) {
+        fd = open(path, O_RDONLY);
+    }
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct hangmanPlayersHeader)) {
+        (void)close(fd);
+        return -1;
+    }
+
+    // Private, the file only changes by being replaced with a snapshot
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    struct hangmanPlayersHeader *header = (struct hangmanPlayersHeader *)mapping;
+    uint64_t capacity = header->capacity;
+
+    if (memcmp(header->magic, PLAYERS_MAGIC, sizeof(header->magic)) != 0 || header->version != PLAYERS_VERSION ||
+        capacity < 2 || (capacity & (capacity - 1)) != 0 ||
+        sizeof(*header) + capacity * sizeof(struct hangmanPlayer) > (uint64_t)st.st_size) {
+        (void)munmap(mapping, (size_t)st.st_size);
+        return -1;
+    }
+
+    players->header = header;
+    players->records = (struct hangmanPlayer *)(header + 1);
+    players->size = (size_t)st.st_size;
+    players->shift = 64 - (unsigned int)__builtin_ctzll(capacity);
+    players->interval = interval;
+    players->path = (char *)malloc(strlen(path) + 1);
+    players->temp = (char *)malloc(strlen(path) + sizeof(".tmp"));
+    players->buffer = (struct hangmanPlayer *)malloc(PLAYERS_CHUNK * sizeof(struct hangmanPlayer));
+
+    if (players->path == NULL || players->temp == NULL || players->buffer == NULL ||
+        pthread_mutex_init(&players->lock, NULL) != 0) {
+        playersClose(players);
+        return -1;
+    }
+
+    (void)strcpy(players->path, path);
+    (void)strcpy(players->temp, path);
+    (void)strcat(players->temp, ".tmp");
+
+    return 0;
+}
+
+/**
+ * Snapshot thread, writes a snapshot every interval
+ * @param  arg The store
+ * @return     Never returns
+ */
+static void *save(void *arg) {
+    struct hangmanPlayers *players = (struct hangmanPlayers *)arg;
+
+#ifdef __linux__
+    struct sched_param param = { 0 };
+    pid_t thread = (pid_t)syscall(SYS_gettid);
+
+    // Snapshots only get CPU time the request threads leave
+    if (syscall(SYS_sched_setscheduler, thread, SCHED_IDLE, &param) == -1) {
+        (void)setpriority(PRIO_PROCESS, (id_t)thread, SAVER_NICE);
+    }
+#endif
+
+    while (1) {
+        struct timespec wait = { players->interval, 0 };
+
+        while (nanosleep(&wait, &wait) == -1 && errno == EINTR) {
+            // Sleep the rest
+        }
+
+        if (playersSnapshot(players) == -1) {
+            (void)printf("Snapshot of %s failed\n", players->path);
+            (void)fflush(stdout);
+        }
+    }
+
+    return NULL;
+}
+
+int playersStart(struct hangmanPlayers *players) {
+    return pthread_create(&players->saver, NULL, save, players) != 0 ? -1 : 0;
+}
+
+int playersSnapshot(struct hangmanPlayers *players) {
+    struct hangmanPlayersHeader header;
+    uint64_t capacity = players->header->capacity;
+    int result = 0;
+
+    (void)pthread_mutex_lock(&players->lock);
+
+    int fd = open(players->temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd == -1) {
+        (void)pthread_mutex_unlock(&players->lock);
+        return -1;
+    }
+
+    header = *players->header;
+    header.count = __atomic_load_n(&players->header->count, __ATOMIC_RELAXED);
+    header.saved = (uint64_t)time(NULL);
+
+    if (writeAll(fd, &header, sizeof(header)) == -1) {
+        result = -1;
+    }
+
+    // Copied record by record, every record is consistent while the others keep changing
+    for (uint64_t first = 0; first < capacity && result == 0; first += PLAYERS_CHUNK) {
+        size_t count = capacity - first < PLAYERS_CHUNK ? (size_t)(capacity - first) : PLAYERS_CHUNK;
+        int used = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            players->buffer[i].key = __atomic_load_n(&players->records[first + i].key, __ATOMIC_ACQUIRE);
+            players->buffer[i].value = __atomic_load_n(&players->records[first + i].value, __ATOMIC_RELAXED);
+            used |= players->buffer[i].key != 0;
+        }
+
+        if (used) {
+            result = writeAll(fd, players->buffer, count * sizeof(struct hangmanPlayer));
+        } else if (lseek(fd, (off_t)(count * sizeof(struct hangmanPlayer)), SEEK_CUR) == -1) {
+            result = -1;
+        }
+    }
+
+    if (result == 0 && (ftruncate(fd, (off_t)(sizeof(header) + capacity * sizeof(struct hangmanPlayer))) == -1 || fsync(fd) == -1)) {
+        result = -1;
+    }
+
+    if (close(fd) == -1) {
+        result = -1;
+    }
+
+    // The file only replaces the last snapshot once it is complete on disk
+    if (result == -1 || rename(players->temp, players->path) == -1) {
+        (void)unlink(players->temp);
+        result = -1;
+    }
+
+    (void)pthread_mutex_unlock(&players->lock);
+
+    return result;
+}
+
+void playersClose(struct hangmanPlayers *players) {
+    if (players->header != NULL) {
+        (void)munmap(players->header, players->size);
+    }
+
+    free(players->path);
+    free(players->temp);
+    free(players->buffer);
+    players->header = NULL;
+    players->records = NULL;
+    players->path = NULL;
+    players->temp = NULL;
+    players->buffer = NULL;
+}
+
+struct hangmanPlayer *playerFind(struct hangmanPlayers *players, uint64_t key) {
+    uint64_t capacity = players->header->capacity;
+    uint64_t mask = capacity - 1;
+    uint64_t i = (key * 0x9e3779b97f4a7c15ull) >> players->shift;
+
+    for (uint64_t probes = 0; probes < capacity; probes++, i = (i + 1) & mask) {
+        uint64_t found = __atomic_load_n(&players->records[i].key, __ATOMIC_ACQUIRE);
+
+        if (found == key) {
+            return &players->records[i];
+        }
+
+        if (found != 0) {
+            continue;
+        }
+
+        // Kept below 3/4 full, probe sequences stay short
+        if (__atomic_load_n(&players->header->count, __ATOMIC_RELAXED) >= capacity / 4 * 3) {
+            return NULL;
+        }
+
+        if (__atomic_compare_exchange_n(&players->records[i].key, &found, key, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            (void)__atomic_add_fetch(&players->header->count, 1, __ATOMIC_RELAXED);
+            return &players->records[i];
+        }
+
+        // Another thread took the record, maybe for the same player
+        if (found == key) {
+            return &players->records[i];
+        }
+    }
+
+    return NULL;
+}
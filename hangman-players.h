@@ -0,0 +1,120 @@
+/**
+ * @file hangman-players.h
+ * @brief Persistent player records of hangman-server. The records are an open addressing table
+ *        in a file that is mapped copy-on-write at startup, so only the pages of players that
+ *        connect are ever read. A snapshot thread writes the table to a new file and renames
+ *        it over the old one, the file on disk is always a complete snapshot
+ */
+#ifndef HANGMAN_PLAYERS_H
+#define HANGMAN_PLAYERS_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PLAYERS_MAGIC    "HANGPLAY"
+#define PLAYERS_VERSION  1
+#define PLAYERS_CAPACITY (1u << 22) // Records of a new file, 64 MiB of which only used pages take space
+#define PLAYERS_INTERVAL 60 // Seconds between snapshots
+
+/**
+ * Header of a player file, the records follow it
+ */
+struct hangmanPlayersHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity; // Records, a power of two
+    uint64_t count; // Records in use
+    uint64_t saved; // Unix time of the snapshot
+    uint64_t padding[3];
+};
+
+/**
+ * Record of one player, a value is replaced with one atomic store and never torn
+ */
+struct hangmanPlayer {
+    uint64_t key; // playerKey, 0 if the record is free
+    uint64_t value; // Won << 48 | lost << 32 | word index + 1
+};
+
+struct hangmanPlayers {
+    struct hangmanPlayersHeader *header; // Start of the mapping
+    struct hangmanPlayer *records;
+    size_t size; // Bytes mapped
+    unsigned int shift; // 64 - log2(capacity), for the hash of a key
+    unsigned int interval; // Seconds between snapshots
+    char *path;
+    char *temp; // path with ".tmp" appended, where the snapshot is written
+    struct hangmanPlayer *buffer; // Records copied for a write
+    pthread_mutex_t lock; // Held while writing a snapshot
+    pthread_t saver;
+};
+
+/**
+ * Maps a player file, a missing file is created empty. Takes the same time for any number of
+ * records, their pages are read on first use
+ * @param  players  Store to open
+ * @param  path     Player file
+ * @param  interval Seconds between snapshots
+ * @return          0 on success, -1 if the file can not be created or is no player file
+ */
+int playersOpen(struct hangmanPlayers *players, const char *path, unsigned int interval);
+
+/**
+ * Starts the snapshot thread
+ * @param  players Store
+ * @return         0 on success, -1 if the thread can not be started
+ */
+int playersStart(struct hangmanPlayers *players);
+
+/**
+ * Writes a snapshot, may be called from any thread while others update records
+ * @param  players Store
+ * @return         0 on success, -1 if the file can not be written
+ */
+int playersSnapshot(struct hangmanPlayers *players);
+
+/**
+ * Unmaps the store, no thread may use it any longer
+ * @param players Store
+ */
+void playersClose(struct hangmanPlayers *players);
+
+/**
+ * Finds the record of a player or adds it, may be called from any thread
+ * @param  players Store
+ * @param  key     playerKey, not 0
+ * @return         The record, NULL if the store is full
+ */
+struct hangmanPlayer *playerFind(struct hangmanPlayers *players, uint64_t key);
+
+/**
+ * Reads a record
+ * @param player Record
+ * @param won    Receives the games won
+ * @param lost   Receives the games lost
+ * @param index  Receives the index of the last word, -1 for a new player
+ */
+static inline void playerLoad(const struct hangmanPlayer *player, short *won, short *lost, int *index) {
+    uint64_t value = __atomic_load_n(&player->value, __ATOMIC_RELAXED);
+
+    *won = (short)(value >> 48);
+    *lost = (short)(value >> 32);
+    *index = (int)(uint32_t)value - 1;
+}
+
+/**
+ * Replaces a record
+ * @param player Record
+ * @param won    Games won
+ * @param lost   Games lost
+ * @param index  Index of the last word
+ */
+static inline void playerStore(struct hangmanPlayer *player, short won, short lost, int index) {
+    uint64_t value = (uint64_t)(uint16_t)won << 48 | (uint64_t)(uint16_t)lost << 32 | (uint32_t)(index + 1);
+
+    __atomic_store_n(&player->value, value, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,32 @@
+/**
+ * @file hangman-proto.c
+ * @brief Texts shared by hangman-server and its clients, compact responses only carry their index
+ */
+#include "hangman-proto.h"
+
+const char *const failureDrawing[10] = {
+    "\n\n\n\n\n\n",
+    "\n\n\n\n\n/\n",
+    "\n\n\n\n\n/ \\\n",
+    "\n\n\n\n |\n/ \\\n",
+    "\n\n\n |\n |\n/ \\\n",
+    "\n\n /\n |\n |\n/ \\\n",
+    "\n  /\n /\n |\n |\n/ \\\n",
+    "   __\n  /\n /   \n |\n |\n/ \\\n",
+    "   __\n  /  |\n /\n |\n |\n/ \\\n",
+    "   __\n  /  |\n /   O\n |  /|\\\n |  / \\\n/ \\\n",
+};
+
+const char *const hangmanMessages[MESSAGES] = {
+    "",
+    "Invalid input.",
+    "Already guessed.",
+    "Invalid input",
+    "Quit game",
+    "No more words",
+    "Client shutdown",
+    "Server full",
+    "Server shutdown",
+    "Hint:",
+    "No hint",
+};
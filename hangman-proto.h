@@ -0,0 +1,379 @@
+/**
+ * @file hangman-proto.h
+ * @brief Protocol between hangman-client and hangman-server (names, shared memory layout and submission ring)
+ */
+#ifndef HANGMAN_PROTO_H
+#define HANGMAN_PROTO_H
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <semaphore.h>
+
+#include <sys/socket.h>
+
+#include "hangman-futex.h"
+
+#define SHM_NAME        "/hangmanData"
+#define SEM_CLIENT      "/hangmanClient"
+#define SEM_LOCKED      "/hangmanLOCKED"
+#define SOCKET_PATH     "/tmp/hangman.sock"
+
+#define INSTANCE_ENV    "HANGMAN_INSTANCE" // Instance name if none is given on the command line
+#define INSTANCE_LENGTH 32 // Longest instance name plus '\0'
+#define NAME_LENGTH     108 // Longest name of a shared object or socket, the size of sun_path
+
+#define PERMISSION      (0600)
+#define MAX_WORD_LENGTH 128
+#define MAX_SLOTS       64 // At most 64, pending requests are a bitmap
+#define MAX_BATCH       26 // Letters in one batched guess, more can never be new
+#define DIFFICULTY_BANDS 4 // Difficulty bands of the words a client can ask for
+
+struct hangmanData {
+    // Server
+    short status; // 0(not ingame), 1(not ingame, wrong input), 2(ingame), 3(ingame, wrong input), -1(disconnect client), -2(server shutdown)
+    char info[128];
+
+    short wrongGuesses;
+    int index;
+    char word[MAX_WORD_LENGTH];
+    char guessed[26];
+    unsigned int guessedMask; // Bit n is set if letter 'A' + n was guessed
+
+    short clientW;
+    short clientL;
+    short applied; // Letters of the batch that were applied
+    // Client
+    int id;
+    char send;
+    short signal;
+    char format; // FORMAT_FULL or FORMAT_COMPACT, how the response is written
+    short batch; // Number of letters in letters, 0 for a single guess in send
+    char band; // Difficulty of the next word, 1 (easy) to DIFFICULTY_BANDS, 0 for any
+    uint64_t player; // playerKey of the player, 0 for an anonymous client
+    char letters[MAX_BATCH];
+};
+
+#define FORMAT_FULL     0 // Response fills this struct (compatibility)
+#define FORMAT_COMPACT  1 // Response is a hangmanReply in the slot
+
+#define REPLY_NEW       1 // A new game started, the word has length underscores
+#define REPLY_WORD      2 // The full word is in hangmanData.word (lost game, very long word or batch)
+
+enum hangmanMessage {
+    MESSAGE_NONE, // Info is the drawing for wrongGuesses
+    MESSAGE_INVALID_GUESS,
+    MESSAGE_ALREADY_GUESSED,
+    MESSAGE_INVALID_ANSWER,
+    MESSAGE_QUIT,
+    MESSAGE_NO_MORE_WORDS,
+    MESSAGE_CLIENT_SHUTDOWN,
+    MESSAGE_SERVER_FULL,
+    MESSAGE_SERVER_SHUTDOWN,
+    MESSAGE_HINT, // Followed by the letter in hangmanReply.hint
+    MESSAGE_NO_HINT,
+    MESSAGES
+};
+
+/**
+ * Compact response, the client keeps the word and renders drawing and messages itself
+ */
+struct hangmanReply {
+    short status;
+    short clientW;
+    short clientL;
+    uint8_t wrongGuesses; // Also index of the drawing
+    uint8_t message; // hangmanMessage
+    uint8_t length; // Length of the word if REPLY_NEW is set
+    uint8_t flags;
+    uint8_t applied; // Letters of the batch that were applied
+    uint8_t hint; // Letter suggested if message is MESSAGE_HINT
+    int index;
+    uint32_t guessedMask;
+    uint32_t revealed; // Positions revealed by this guess
+};
+
+#define WAIT_SEM        0 // Doorbell and replies are semaphores
+#define WAIT_FUTEX      1 // Doorbell and replies are hangmanEvents, waiters spin before they sleep
+
+#ifdef __linux__
+#define WAIT_DEFAULT    WAIT_SEM
+#else
+#define WAIT_DEFAULT    WAIT_FUTEX // No unnamed semaphores shared between processes
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL    0 // Sockets are only served on Linux
+#endif
+
+#define ADMISSION_SEM   0 // SEM_LOCKED counts the free slots, no order among waiters
+#define ADMISSION_FIFO  1 // Tickets, slots are handed out in arrival order
+
+#define ADMISSION_HOLDERS 16384 // Waiting tickets whose owner can be checked, power of two
+#define ADMISSION_TURNS   256 // Futex words waiters sleep on, by ticket, power of two
+
+#define TRANSPORT_SHM     0 // Slots in shared memory, named semaphores
+#define TRANSPORT_SOCKET  1 // SOCK_SEQPACKET Unix socket, replies are always compact
+
+/**
+ * Request packet of the socket transport, the client fields of hangmanData
+ */
+struct hangmanRequest {
+    int id;
+    char send;
+    char signal;
+    uint8_t batch;
+    uint8_t band;
+    uint64_t player;
+    char letters[MAX_BATCH];
+};
+
+/**
+ * Response packet of the socket transport, word is only sent if REPLY_WORD is set
+ */
+struct hangmanResponse {
+    struct hangmanReply reply;
+    char word[MAX_WORD_LENGTH];
+};
+
+/**
+ * Drawing for each number of wrong guesses
+ */
+extern const char *const failureDrawing[10];
+
+/**
+ * Text of each hangmanMessage
+ */
+extern const char *const hangmanMessages[MESSAGES];
+
+/**
+ * Mailbox of one connected client
+ */
+#define SLOT_FREE       0
+#define SLOT_RECLAIMING (-1) // The owner died, the server drops its session and frees the slot
+
+struct hangmanSlot {
+    int owner; // pid of the client that claimed the slot, or SLOT_FREE, SLOT_RECLAIMING
+    sem_t reply; // Posted by the server once the response is written (WAIT_SEM)
+    struct hangmanEvent replied; // Same for WAIT_FUTEX
+    struct hangmanData data;
+    struct hangmanReply compact;
+};
+
+/**
+ * Owner of a waiting ticket
+ */
+struct hangmanTicket {
+    uint32_t ticket;
+    int pid;
+};
+
+/**
+ * Fair admission to the slots. Only the client holding the ticket being served may claim a
+ * slot, afterwards it passes the turn to the next ticket. A ticket whose owner died is skipped
+ */
+struct hangmanAdmission {
+    uint32_t next; // Next ticket to hand out
+    char pad0[60];
+    uint32_t serving; // Ticket allowed to claim a slot
+    uint32_t released; // Bumped for every released slot, the serving client sleeps on it
+    char pad1[56];
+    uint32_t turn[ADMISSION_TURNS]; // Bumped when the ticket with this index becomes served
+    struct hangmanTicket holders[ADMISSION_HOLDERS];
+};
+
+/**
+ * Shared memory segment between server and clients
+ */
+struct hangmanShm {
+    short status; // 0(running), -2(server shutdown)
+    int server; // pid of the server, clients stop waiting once it is gone
+    uint32_t wait; // WAIT_SEM or WAIT_FUTEX, chosen by the server
+    uint32_t spin; // Spin limit of the waiters for WAIT_FUTEX
+    struct hangmanEvent doorbell; // Replaces SEM_CLIENT for WAIT_FUTEX
+    uint32_t admission; // ADMISSION_SEM or ADMISSION_FIFO, chosen by the server
+    struct hangmanAdmission fifo; // Replaces SEM_LOCKED for ADMISSION_FIFO
+    uint64_t pending __attribute__((aligned(64))); // Bit n is set while slot n holds an unserved request
+    struct hangmanSlot slots[MAX_SLOTS];
+};
+
+/**
+ * Marks the request in a slot as pending, a single atomic operation a crashing client can
+ * not leave half done
+ * @param shm  Shared memory segment
+ * @param slot Index of the slot with a new request
+ */
+static inline void pendingPush(struct hangmanShm *shm, int slot) {
+    (void)__atomic_fetch_or(&shm->pending, (uint64_t)1 << slot, __ATOMIC_RELEASE);
+}
+
+/**
+ * Takes all pending requests, only called by the server
+ * @param  shm Shared memory segment
+ * @return     Bit n is set if slot n holds a request
+ */
+static inline uint64_t pendingTake(struct hangmanShm *shm) {
+    return __atomic_exchange_n(&shm->pending, 0, __ATOMIC_ACQUIRE);
+}
+
+#define PROCESS_UNKNOWN UINT64_MAX // Start time of a running process without procfs
+
+/**
+ * Start time of a process, tells a client apart from a later process that reuses its pid
+ * @param  pid The process
+ * @return     Start time in clock ticks since boot, 0 if it is gone or a zombie,
+ *             PROCESS_UNKNOWN if it runs but the start time can not be read
+ */
+static inline uint64_t processStarted(int pid) {
+    char path[32];
+    char stat[512];
+
+    if (kill(pid, 0) == -1 && errno == ESRCH) {
+        return 0;
+    }
+
+#ifndef __linux__
+    return PROCESS_UNKNOWN; // No procfs, the pid alone has to do
+#endif
+
+    (void)snprintf(path, sizeof(path), "/proc/%i/stat", pid);
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return errno == ENOENT ? 0 : PROCESS_UNKNOWN;
+    }
+
+    ssize_t length = read(fd, stat, sizeof(stat) - 1);
+    (void)close(fd);
+
+    char *field = NULL;
+
+    // The name in parentheses may contain anything, the fields after it are plain numbers
+    if (length > 0) {
+        stat[length] = '\0';
+        field = strrchr(stat, ')');
+    }
+
+    if (field == NULL || field[1] != ' ') {
+        return PROCESS_UNKNOWN;
+    }
+
+    field += 2;
+
+    if (*field == 'Z' || *field == 'X') {
+        return 0;
+    }
+
+    // Field 22 of stat, 19 fields after the state
+    for (int i = 0; i < 19 && field != NULL; i++) {
+        field = strchr(field, ' ');
+        field = field != NULL ? field + 1 : NULL;
+    }
+
+    return field != NULL ? strtoull(field, NULL, 10) : PROCESS_UNKNOWN;
+}
+
+/**
+ * Checks if a process still runs, a zombie counts as dead
+ * @param  pid The process
+ * @return     1 if it runs, 0 if it is gone
+ */
+static inline int processAlive(int pid) {
+    return processStarted(pid) != 0;
+}
+
+/**
+ * Waits for a semaphore until a deadline, polls where sem_timedwait is missing
+ * @param  sem      Semaphore
+ * @param  deadline Absolute CLOCK_REALTIME deadline
+ * @return          0 once decremented, -1 on an error (EINTR, ETIMEDOUT)
+ */
+static inline int semWaitUntil(sem_t *sem, const struct timespec *deadline) {
+#ifdef __linux__
+    return sem_timedwait(sem, deadline);
+#else
+    struct timespec interval = { 0, FUTEX_POLL_MAX };
+    struct timespec now;
+
+    while (sem_trywait(sem) == -1) {
+        if (errno != EAGAIN) {
+            return -1;
+        }
+
+        (void)clock_gettime(CLOCK_REALTIME, &now);
+
+        if (now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec)) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+
+        if (nanosleep(&interval, NULL) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+#endif
+}
+
+/**
+ * Checks an instance name, letters, digits, '-' and '_' only
+ * @param  instance Name of the instance, "" for the unnamed one
+ * @return          1 if it can be used, 0 otherwise
+ */
+static inline int instanceValid(const char *instance) {
+    size_t length = strlen(instance);
+
+    for (size_t i = 0; i < length; i++) {
+        char c = instance[i];
+
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_')) {
+            return 0;
+        }
+    }
+
+    return length < INSTANCE_LENGTH;
+}
+
+/**
+ * Name of a shared object of a server instance, the unnamed instance keeps the plain names so
+ * a single server works as before
+ * @param buffer   Receives the name, NAME_LENGTH bytes
+ * @param base     SHM_NAME, SEM_CLIENT, SEM_LOCKED, SOCKET_PATH, METRICS_NAME or ROOM_NAME
+ * @param instance Valid instance name, "" for the unnamed instance
+ */
+static inline void instanceName(char *buffer, const char *base, const char *instance) {
+    (void)snprintf(buffer, NAME_LENGTH, instance[0] != '\0' ? "%s.%s" : "%s", base, instance);
+}
+
+/**
+ * Instance name from the environment
+ * @return HANGMAN_INSTANCE, NULL if it is not set
+ */
+static inline const char *instanceDefault(void) {
+    return getenv(INSTANCE_ENV);
+}
+
+/**
+ * Stable identity of a player name (FNV-1a), the same name is the same player across
+ * connections and server restarts
+ * @param  name Name of the player
+ * @return      Key of the player, never 0
+ */
+static inline uint64_t playerKey(const char *name) {
+    uint64_t key = 14695981039346656037ull;
+
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0'; c++) {
+        key = (key ^ *c) * 1099511628211ull;
+    }
+
+    return key != 0 ? key : 1;
+}
+
+#endif
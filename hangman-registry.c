@@ -0,0 +1,251 @@
+/**
+ * @file hangman-registry.c
+ * @brief Registry of the hangman-server instances on a host
+ */
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hangman-registry.h"
+
+/**
+ * Mixes the bits of a value (splitmix64 finalizer)
+ * @param  x Value
+ * @return   Mixed value
+ */
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Weight of an instance for a client, every client ranks the instances by it (rendezvous
+ * hashing), so only the clients of an instance that comes or goes move
+ * @param  name Instance name
+ * @param  id   ID of the client
+ * @return      Weight
+ */
+static uint64_t weight(const char *name, int id) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (const char *c = name; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 0x100000001b3ull;
+    }
+
+    return mix(hash ^ (uint64_t)(uint32_t)id);
+}
+
+/**
+ * Copies an entry if its server is running
+ * @param  entry    Entry of the registry
+ * @param  instance Receives the entry
+ * @return          1 if the server runs, 0 if the entry is free, being filled in or left by a dead server
+ */
+static int instanceRead(const struct hangmanInstance *entry, struct hangmanInstance *instance) {
+    uint64_t started = __atomic_load_n(&entry->started, __ATOMIC_ACQUIRE);
+
+    if (started == 0) {
+        return 0;
+    }
+
+    instance->pid = __atomic_load_n(&entry->pid, __ATOMIC_RELAXED);
+    instance->transport = entry->transport;
+    instance->sessions = __atomic_load_n(&entry->sessions, __ATOMIC_RELAXED);
+    instance->capacity = entry->capacity;
+    (void)memcpy(instance->name, entry->name, sizeof(instance->name));
+    instance->name[INSTANCE_LENGTH - 1] = '\0';
+    instance->started = started;
+
+    // The entry was reused while it was copied
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&entry->started, __ATOMIC_RELAXED) != started) {
+        return 0;
+    }
+
+    return processStarted(instance->pid) == started;
+}
+
+/**
+ * Frees an entry, clients stop routing to it before another server can claim it
+ * @param entry Entry of this process
+ */
+static void release(struct hangmanInstance *entry) {
+    __atomic_store_n(&entry->started, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&entry->pid, 0, __ATOMIC_RELEASE);
+}
+
+int registryOpen(struct hangmanRegistry *registry, int create) {
+    struct stat st;
+
+    registry->shm = NULL;
+    registry->own = NULL;
+
+    int fd = shm_open(REGISTRY_NAME, create ? O_CREAT | O_RDWR : O_RDONLY, PERMISSION);
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    // Growing a new segment zeroes it, the same size again leaves the entries alone
+    if ((create && ftruncate(fd, sizeof(struct hangmanRegistryShm)) == -1) || fstat(fd, &st) == -1 ||
+        (size_t)st.st_size < sizeof(struct hangmanRegistryShm)) {
+        (void)close(fd);
+        return -1;
+    }
+
+    void *mapping = mmap(NULL, sizeof(struct hangmanRegistryShm), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    registry->shm = (struct hangmanRegistryShm *)mapping;
+
+    return 0;
+}
+
+int registryJoin(struct hangmanRegistry *registry, const char *name, int transport, uint32_t capacity) {
+    struct hangmanInstance instance;
+    struct hangmanInstance *own = NULL;
+    int pid = (int)getpid();
+
+    for (size_t i = 0; i < REGISTRY_ENTRIES; i++) {
+        if (instanceRead(&registry->shm->instance[i], &instance) && strcmp(instance.name, name) == 0) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < REGISTRY_ENTRIES && own == NULL; i++) {
+        struct hangmanInstance *entry = &registry->shm->instance[i];
+        int owner = __atomic_load_n(&entry->pid, __ATOMIC_ACQUIRE);
+
+        // Taken over if free or left behind by a server that died, an entry being filled in has no start time yet
+        if (owner != 0) {
+            uint64_t running = processStarted(owner);
+            uint64_t claimed = __atomic_load_n(&entry->started, __ATOMIC_ACQUIRE);
+
+            if (running != 0 && (claimed == 0 || claimed == running)) {
+                continue;
+            }
+        }
+
+        if (__atomic_compare_exchange_n(&entry->pid, &owner, pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            own = entry;
+        }
+    }
+
+    if (own == NULL) {
+        return -1;
+    }
+
+    __atomic_store_n(&own->started, 0, __ATOMIC_RELAXED);
+    own->transport = transport;
+    own->capacity = capacity;
+    __atomic_store_n(&own->sessions, 0, __ATOMIC_RELAXED);
+    memset(own->name, 0, sizeof(own->name));
+    (void)strncpy(own->name, name, sizeof(own->name) - 1);
+    __atomic_store_n(&own->started, processStarted(pid), __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // Two servers of the same name joined at once, at least one of them sees the other
+    for (size_t i = 0; i < REGISTRY_ENTRIES; i++) {
+        struct hangmanInstance *entry = &registry->shm->instance[i];
+
+        if (entry != own && instanceRead(entry, &instance) && strcmp(instance.name, name) == 0) {
+            release(own);
+            return -1;
+        }
+    }
+
+    __atomic_store_n(&registry->own, own, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void registryUpdate(struct hangmanRegistry *registry, uint32_t sessions) {
+    struct hangmanInstance *own = __atomic_load_n(&registry->own, __ATOMIC_ACQUIRE);
+
+    if (own != NULL) {
+        __atomic_store_n(&own->sessions, sessions, __ATOMIC_RELAXED);
+    }
+}
+
+int registryRoute(const struct hangmanRegistry *registry, int transport, int id, enum hangmanRoute route, char *name) {
+    struct hangmanInstance instance;
+    struct hangmanInstance best[2]; // Highest weights, best[0] first
+    uint64_t weights[2] = { 0, 0 };
+    int found = 0;
+
+    for (size_t i = 0; i < REGISTRY_ENTRIES; i++) {
+        if (!instanceRead(&registry->shm->instance[i], &instance) || instance.transport != transport) {
+            continue;
+        }
+
+        uint64_t w = weight(instance.name, id);
+
+        if (found == 0 || w > weights[0]) {
+            best[1] = best[0];
+            weights[1] = weights[0];
+            best[0] = instance;
+            weights[0] = w;
+        } else if (found == 1 || w > weights[1]) {
+            best[1] = instance;
+            weights[1] = w;
+        }
+
+        found++;
+    }
+
+    if (found == 0) {
+        return -1;
+    }
+
+    int pick = 0;
+
+    // Fewer sessions per capacity, compared without dividing
+    if (route == ROUTE_LOAD && found > 1 &&
+        (uint64_t)best[1].sessions * best[0].capacity < (uint64_t)best[0].sessions * best[1].capacity) {
+        pick = 1;
+    }
+
+    (void)memcpy(name, best[pick].name, INSTANCE_LENGTH);
+
+    return 0;
+}
+
+int registryList(const struct hangmanRegistry *registry, struct hangmanInstance *instances) {
+    int count = 0;
+
+    for (size_t i = 0; i < REGISTRY_ENTRIES; i++) {
+        if (instanceRead(&registry->shm->instance[i], &instances[count])) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void registryLeave(struct hangmanRegistry *registry) {
+    struct hangmanInstance *own = __atomic_exchange_n(&registry->own, NULL, __ATOMIC_ACQ_REL);
+
+    if (own != NULL) {
+        release(own);
+    }
+}
+
+void registryClose(struct hangmanRegistry *registry) {
+    registryLeave(registry);
+
+    if (registry->shm != NULL) {
+        (void)munmap(registry->shm, sizeof(struct hangmanRegistryShm));
+        registry->shm = NULL;
+    }
+}
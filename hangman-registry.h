@@ -0,0 +1,105 @@
+/**
+ * @file hangman-registry.h
+ * @brief Registry of the hangman-server instances on a host. Every server claims an entry of a
+ *        shared segment and publishes its load there, clients pick an instance from it. The
+ *        segment is shared by all instances and never unlinked, an entry of a process that died
+ *        is recognized by its start time and taken over by the next server
+ */
+#ifndef HANGMAN_REGISTRY_H
+#define HANGMAN_REGISTRY_H
+
+#include <stdint.h>
+
+#include "hangman-proto.h"
+
+#define REGISTRY_NAME    "/hangmanRegistry"
+#define REGISTRY_ENTRIES 64
+
+enum hangmanRoute {
+    ROUTE_HASH, // Same id, same instance while the instances stay the same
+    ROUTE_LOAD // Less loaded of the two instances the id hashes to, a burst of clients that all
+               // see the same published load does not pile onto one instance
+};
+
+/**
+ * Entry of one server instance
+ */
+struct hangmanInstance {
+    int pid; // Server, 0 if the entry is free
+    int transport; // TRANSPORT_SHM or TRANSPORT_SOCKET
+    uint64_t started; // processStarted of the server, written last, 0 while the entry is filled in
+    uint32_t sessions; // Clients with a session
+    uint32_t capacity; // Sessions the instance can hold
+    char name[INSTANCE_LENGTH]; // "" for the unnamed instance
+};
+
+/**
+ * The shared segment, all zero when created
+ */
+struct hangmanRegistryShm {
+    struct hangmanInstance instance[REGISTRY_ENTRIES];
+};
+
+struct hangmanRegistry {
+    struct hangmanRegistryShm *shm;
+    struct hangmanInstance *own; // Entry of this server, NULL for clients
+};
+
+/**
+ * Maps the registry
+ * @param  registry Registry to initialize
+ * @param  create   1 to create a missing segment (servers), 0 to fail instead (clients)
+ * @return          0 on success, -1 if the segment is missing or can not be mapped
+ */
+int registryOpen(struct hangmanRegistry *registry, int create);
+
+/**
+ * Claims an entry for this process
+ * @param  registry  Open registry
+ * @param  name      Instance name
+ * @param  transport TRANSPORT_SHM or TRANSPORT_SOCKET
+ * @param  capacity  Clients served at once
+ * @return           0 on success, -1 if an instance with this name is running or no entry is free
+ */
+int registryJoin(struct hangmanRegistry *registry, const char *name, int transport, uint32_t capacity);
+
+/**
+ * Publishes the load of this instance
+ * @param registry Joined registry
+ * @param sessions Clients with a session
+ */
+void registryUpdate(struct hangmanRegistry *registry, uint32_t sessions);
+
+/**
+ * Picks a running instance for a client
+ * @param  registry  Open registry
+ * @param  transport TRANSPORT_SHM or TRANSPORT_SOCKET
+ * @param  id        ID of the client, usually the pid
+ * @param  route     ROUTE_HASH or ROUTE_LOAD
+ * @param  name      Receives the instance name, INSTANCE_LENGTH bytes
+ * @return           0 on success, -1 if no instance with this transport is running
+ */
+int registryRoute(const struct hangmanRegistry *registry, int transport, int id, enum hangmanRoute route, char *name);
+
+/**
+ * Copies the running instances
+ * @param  registry  Open registry
+ * @param  instances Receives the entries, REGISTRY_ENTRIES of them
+ * @return           Number of running instances
+ */
+int registryList(const struct hangmanRegistry *registry, struct hangmanInstance *instances);
+
+/**
+ * Gives the entry of this process back, if it has one. Other threads may still call
+ * registryUpdate, which then does nothing
+ * @param registry Registry
+ */
+void registryLeave(struct hangmanRegistry *registry);
+
+/**
+ * Gives the entry of this process back, if it has one, and unmaps the registry
+ * @param registry Registry
+ */
+void registryClose(struct hangmanRegistry *registry);
+
+#endif
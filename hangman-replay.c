@@ -0,0 +1,480 @@
+/**
+ * @file hangman-replay.c
+ * @brief Replays a trace recorded by hangman-server -T against a running server. Every traced
+ *        client is played by its own process in its recorded order, either as fast as possible
+ *        or at the recorded pacing, and the state after every request is compared with the trace
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "hangman-conn.h"
+#include "hangman-hist.h"
+#include "hangman-trace.h"
+
+#define DEFAULT_CONCURRENCY 256 // Clients replayed at once
+
+/**
+ * Traced request with its letters
+ */
+struct hangmanReplayRequest {
+    struct hangmanTraceRecord record;
+    char letters[MAX_BATCH];
+};
+
+/**
+ * Requests of one traced client, in the order of the trace
+ */
+struct hangmanReplayClient {
+    size_t first; // Index into the sorted requests
+    size_t count;
+};
+
+/**
+ * Statistics of one replay process, written by the processes using it one after another
+ */
+struct hangmanReplayStats {
+    uint64_t requests;
+    uint64_t mismatches; // Requests whose state differs from the trace
+    uint64_t diverged; // Clients whose final state differs from the trace
+    uint64_t errors;
+    uint64_t latency[HIST_BUCKETS]; // Round trip of every request in ns
+};
+
+char *progname;
+
+char transport = TRANSPORT_SHM;
+
+const char *instance = NULL; // Every client picks its own from the registry unless -n or HANGMAN_INSTANCE is given
+
+struct hangmanReplayRequest *requests;
+
+/**
+ * Exits the programm and writes a usage description to stderr
+ */
+static void usage(void) {
+    (void)fprintf(stderr, "Usage: %s [-c concurrency] [-n instance] [-p] [-u] trace-file\n"
+                  "\t-c replay at most concurrency clients at once (default 256)\n"
+                  "\t-p keep the recorded pacing instead of sending as fast as possible\n"
+                  "\t-u connect over the Unix socket of a server started with -u\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Sleeps until a point in time
+ * @param deadline Monotonic time in ns
+ */
+static void sleepUntil(uint64_t deadline) {
+    uint64_t current = now();
+
+    while (current < deadline) {
+        struct timespec wait = { (time_t)((deadline - current) / 1000000000u), (long)((deadline - current) % 1000000000u) };
+
+        (void)nanosleep(&wait, NULL);
+        current = now();
+    }
+}
+
+/**
+ * Orders requests by client, keeping the order of the trace within a client
+ */
+static int compareRequests(const void *a, const void *b) {
+    const struct hangmanReplayRequest *x = (const struct hangmanReplayRequest *)a;
+    const struct hangmanReplayRequest *y = (const struct hangmanReplayRequest *)b;
+
+    if (x->record.id != y->record.id) {
+        return x->record.id < y->record.id ? -1 : 1;
+    }
+
+    return x->record.time < y->record.time ? -1 : x->record.time > y->record.time;
+}
+
+/**
+ * Orders clients by their first request
+ */
+static int compareClients(const void *a, const void *b) {
+    uint64_t x = requests[((const struct hangmanReplayClient *)a)->first].record.time;
+    uint64_t y = requests[((const struct hangmanReplayClient *)b)->first].record.time;
+
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Reads a trace
+ * @param  path    Trace file
+ * @param  header  Receives the header
+ * @param  count   Receives the number of requests
+ * @return         The requests, NULL if the file is no complete trace
+ */
+static struct hangmanReplayRequest *load(const char *path, struct hangmanTraceHeader *header, size_t *count) {
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    if (fread(header, sizeof(*header), 1, file) != 1 || memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TRACE_VERSION || header->recordSize != sizeof(struct hangmanTraceRecord)) {
+        (void)fclose(file);
+        return NULL;
+    }
+
+    // A trace of a server that did not shut down has no record count, its records are read up to the end
+    size_t capacity = header->records > 0 ? (size_t)header->records : 4096;
+    struct hangmanReplayRequest *loaded = (struct hangmanReplayRequest *)malloc(capacity * sizeof(*loaded));
+    size_t n = 0;
+
+    while (loaded != NULL && (header->records == 0 || n < header->records)) {
+        if (n == capacity) {
+            struct hangmanReplayRequest *grown = (struct hangmanReplayRequest *)realloc(loaded, 2 * capacity * sizeof(*loaded));
+
+            if (grown == NULL) {
+                free(loaded);
+                loaded = NULL;
+                break;
+            }
+
+            loaded = grown;
+            capacity *= 2;
+        }
+
+        if (fread(&loaded[n].record, sizeof(loaded[n].record), 1, file) != 1) {
+            // Missing records of a complete trace
+            if (header->records > 0) {
+                free(loaded);
+                loaded = NULL;
+            }
+
+            break;
+        }
+
+        if (loaded[n].record.batch > MAX_BATCH ||
+            fread(loaded[n].letters, 1, loaded[n].record.batch, file) != loaded[n].record.batch) {
+            free(loaded);
+            loaded = NULL;
+            break;
+        }
+
+        n++;
+    }
+
+    (void)fclose(file);
+
+    header->records = n;
+    *count = n;
+
+    return loaded;
+}
+
+/**
+ * Compares the state after a request with the trace
+ * @param  reply  Reply of the server
+ * @param  record Traced request
+ * @return        1 if they are the same, 0 otherwise
+ */
+static int matches(const struct hangmanReply *reply, const struct hangmanTraceRecord *record) {
+    return reply->status == record->status && reply->clientW == record->clientW && reply->clientL == record->clientL &&
+           reply->wrongGuesses == record->wrongGuesses && reply->index == record->index && reply->guessedMask == record->guessedMask;
+}
+
+/**
+ * Plays the requests of one traced client
+ * @param client Client to play
+ * @param stats  Statistics of this process
+ * @param start  Monotonic time the replay started, for the recorded pacing
+ * @param origin Time of the first request of the trace
+ * @param paced  1 to keep the recorded pacing
+ */
+static void play(const struct hangmanReplayClient *client, struct hangmanReplayStats *stats, uint64_t start, uint64_t origin, int paced) {
+    struct hangmanConn conn;
+    char routed[INSTANCE_LENGTH];
+    const char *name = instance;
+    int claimed = 0;
+    int same = 1;
+
+    if (name == NULL) {
+        connRoute(transport, getpid(), ROUTE_HASH, routed);
+        name = routed;
+    }
+
+    if ((transport == TRANSPORT_SOCKET ? connOpenSocket(&conn, name) : connOpen(&conn, name)) < 0) {
+        stats->errors++;
+        stats->diverged++;
+        return;
+    }
+
+    for (size_t i = client->first; i < client->first + client->count; i++) {
+        const struct hangmanReplayRequest *request = &requests[i];
+
+        if (paced) {
+            sleepUntil(start + (request->record.time - origin));
+        }
+
+        if (!claimed && connClaim(&conn, getpid()) < 0) {
+            stats->errors++;
+            same = 0;
+            break;
+        }
+
+        claimed = 1;
+
+        conn.data->id = conn.id;
+        conn.data->send = request->record.send;
+        conn.data->signal = request->record.signal;
+        conn.data->format = FORMAT_COMPACT;
+        conn.data->batch = (short)request->record.batch;
+        conn.data->band = (char)request->record.band;
+        conn.data->player = request->record.player;
+        (void)memcpy(conn.data->letters, request->letters, request->record.batch);
+
+        uint64_t sent = now();
+
+        if (connSubmit(&conn) < 0) {
+            stats->errors++;
+            same = 0;
+            claimed = 0;
+            break;
+        }
+
+        stats->latency[histBucket(now() - sent)]++;
+        stats->requests++;
+        same = matches(conn.reply, &request->record);
+
+        if (!same) {
+            stats->mismatches++;
+        }
+
+        // The server removed the session, the traced client went on with a new connection
+        if (conn.reply->status < 0) {
+            connRelease(&conn);
+            claimed = 0;
+        }
+    }
+
+    // A client the trace ends with leaves like an interrupted client
+    if (claimed) {
+        conn.data->id = conn.id;
+        conn.data->send = '\0';
+        conn.data->signal = 1;
+        conn.data->format = FORMAT_COMPACT;
+        conn.data->batch = 0;
+        (void)connSubmit(&conn);
+    }
+
+    if (!same) {
+        stats->diverged++;
+    }
+
+    connClose(&conn);
+}
+
+/**
+ * Main
+ * @brief     Main Function
+ * @param     argc Number of arguments
+ * @param     argv Array of arguments of type char*
+ * @result    int EXIT_SUCCESS or in case of an error EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    progname = argv[0];
+    long concurrency = DEFAULT_CONCURRENCY;
+    int paced = 0;
+    char *end;
+    int c;
+
+    while ((c = getopt(argc, argv, "c:n:pu")) != -1) {
+        switch (c) {
+            case 'c':
+                concurrency = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || concurrency < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 'n':
+                instance = optarg;
+                break;
+
+            case 'p':
+                paced = 1;
+                break;
+
+            case 'u':
+                transport = TRANSPORT_SOCKET;
+                break;
+
+            case '?':
+                usage();
+                break;
+
+            default:
+                assert(0);
+        }
+    }
+
+    if (argc - optind != 1) {
+        usage();
+    }
+
+    if (instance == NULL) {
+        instance = instanceDefault();
+    }
+
+    if (instance != NULL && !instanceValid(instance)) {
+        (void)fprintf(stderr, "%s: Invalid instance name\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    // MARK: Trace
+
+    struct hangmanTraceHeader header;
+    size_t count;
+
+    requests = load(argv[optind], &header, &count);
+
+    if (requests == NULL) {
+        (void)fprintf(stderr, "%s: %s is no trace\n", progname, argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    qsort(requests, count, sizeof(*requests), compareRequests);
+
+    struct hangmanReplayClient *clients = (struct hangmanReplayClient *)malloc((count > 0 ? count : 1) * sizeof(*clients));
+    size_t clientCount = 0;
+    uint64_t origin = UINT64_MAX;
+
+    if (clients == NULL) {
+        (void)fprintf(stderr, "%s: malloc\n", progname);
+        free(requests);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || requests[i].record.id != requests[i - 1].record.id) {
+            clients[clientCount].first = i;
+            clients[clientCount].count = 0;
+            clientCount++;
+        }
+
+        clients[clientCount - 1].count++;
+
+        if (requests[i].record.time < origin) {
+            origin = requests[i].record.time;
+        }
+    }
+
+    // Clients start in the order they first appeared in
+    qsort(clients, clientCount, sizeof(*clients), compareClients);
+
+    if ((size_t)concurrency > clientCount) {
+        concurrency = clientCount > 0 ? (long)clientCount : 1;
+    }
+
+    // MARK: Replay
+
+    // One statistics block per concurrent process, summed up by the parent
+    struct hangmanReplayStats *stats = (struct hangmanReplayStats *)mmap(NULL, concurrency * sizeof(struct hangmanReplayStats),
+                                                                         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t *running = (pid_t *)calloc((size_t)concurrency, sizeof(pid_t));
+
+    if (stats == MAP_FAILED || running == NULL) {
+        (void)fprintf(stderr, "%s: mmap\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t start = now();
+    long active = 0;
+    uint64_t failed = 0;
+
+    for (size_t i = 0; i < clientCount; i++) {
+        long slot = 0;
+
+        // A process for every client, a slot is reused once its process is done
+        if (active == concurrency) {
+            pid_t done;
+
+            while ((done = wait(NULL)) == -1 && errno == EINTR) {
+            }
+
+            while (slot < concurrency - 1 && running[slot] != done) {
+                slot++;
+            }
+
+            active--;
+        } else {
+            while (running[slot] != 0) {
+                slot++;
+            }
+        }
+
+        pid_t pid = fork();
+
+        if (pid == -1) {
+            (void)fprintf(stderr, "%s: fork\n", progname);
+            running[slot] = 0;
+            failed += clientCount - i;
+            break;
+        } else if (pid == 0) {
+            play(&clients[i], &stats[slot], start, origin, paced);
+            _exit(EXIT_SUCCESS);
+        }
+
+        running[slot] = pid;
+        active++;
+    }
+
+    while (wait(NULL) > 0) {
+        // Wait for the last clients
+    }
+
+    double elapsed = (now() - start) / 1e9;
+    struct hangmanReplayStats total;
+    memset(&total, 0, sizeof(total));
+
+    for (long i = 0; i < concurrency; i++) {
+        total.requests += stats[i].requests;
+        total.mismatches += stats[i].mismatches;
+        total.diverged += stats[i].diverged;
+        total.errors += stats[i].errors;
+
+        for (int j = 0; j < HIST_BUCKETS; j++) {
+            total.latency[j] += stats[i].latency[j];
+        }
+    }
+
+    total.diverged += failed;
+
+    (void)printf("{\"clients\":%zu,\"transport\":\"%s\",\"paced\":%s,\"seconds\":%.3f,\"traced\":%zu,\"dropped\":%llu,\"requests\":%llu,\"errors\":%llu,"
+                 "\"requests_per_sec\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,"
+                 "\"mismatched_requests\":%llu,\"diverged_clients\":%llu}\n",
+                 clientCount, transport == TRANSPORT_SOCKET ? "socket" : "shm", paced ? "true" : "false", elapsed, count,
+                 (unsigned long long)header.dropped, (unsigned long long)total.requests, (unsigned long long)total.errors,
+                 total.requests / elapsed, (unsigned long long)histPercentile(total.latency, 0.5),
+                 (unsigned long long)histPercentile(total.latency, 0.99), (unsigned long long)histPercentile(total.latency, 0.999),
+                 (unsigned long long)total.mismatches, (unsigned long long)total.diverged);
+
+    (void)munmap(stats, concurrency * sizeof(struct hangmanReplayStats));
+    free(running);
+    free(clients);
+    free(requests);
+
+    return total.errors == 0 && total.diverged == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file hangman-ring.c
+ * @brief Lock-free record ring of hangman-server
+ */
+#include <stdlib.h>
+#include <time.h>
+
+#include "hangman-ring.h"
+
+#define RING_HEADER 8 // Sequence of a slot, keeps the record aligned to 8
+
+/**
+ * Sequence of a slot: its position while free, position + 1 once the record is published
+ * @param  ring Ring
+ * @param  pos  Position
+ * @return      The sequence
+ */
+static unsigned int *sequence(const struct hangmanRing *ring, unsigned int pos) {
+    return (unsigned int *)(ring->slots + (size_t)(pos & (ring->capacity - 1)) * ring->slotSize);
+}
+
+/**
+ * Hands every published record to the consumer
+ * @param  ring Ring
+ * @return      Number of records consumed
+ */
+static int drain(struct hangmanRing *ring) {
+    int count = 0;
+
+    while (1) {
+        unsigned int *seq = sequence(ring, ring->head);
+
+        if (__atomic_load_n(seq, __ATOMIC_ACQUIRE) != ring->head + 1) {
+            break;
+        }
+
+        ring->consume(ring, (char *)seq + RING_HEADER);
+        __atomic_store_n(seq, ring->head + ring->capacity, __ATOMIC_RELEASE);
+        ring->head++;
+        count++;
+    }
+
+    if (ring->batch != NULL) {
+        ring->batch(ring, count);
+    }
+
+    return count;
+}
+
+/**
+ * Background thread, consumes batches until stopped
+ * @param  arg The ring
+ * @return     NULL
+ */
+static void *consumer(void *arg) {
+    struct hangmanRing *ring = (struct hangmanRing *)arg;
+    struct timespec interval = { 0, ring->interval };
+
+    while (__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE)) {
+        if (drain(ring) == 0) {
+            (void)nanosleep(&interval, NULL);
+        }
+    }
+
+    (void)drain(ring);
+
+    return NULL;
+}
+
+int ringInit(struct hangmanRing *ring, unsigned int capacity, size_t recordSize, long interval,
+             hangmanRingConsume consume, hangmanRingBatch batch) {
+    ring->slotSize = (RING_HEADER + recordSize + 7) & ~(size_t)7;
+    ring->slots = (char *)malloc(capacity * ring->slotSize);
+
+    if (ring->slots == NULL) {
+        return -1;
+    }
+
+    ring->capacity = capacity;
+    ring->tail = 0;
+    ring->head = 0;
+    ring->dropped = 0;
+    ring->interval = interval;
+    ring->running = 0;
+    ring->consume = consume;
+    ring->batch = batch;
+
+    for (unsigned int i = 0; i < capacity; i++) {
+        *sequence(ring, i) = i;
+    }
+
+    return 0;
+}
+
+void ringFree(struct hangmanRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+int ringStart(struct hangmanRing *ring) {
+    ring->running = 1;
+
+    if (pthread_create(&ring->thread, NULL, consumer, ring) != 0) {
+        ring->running = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+void ringStop(struct hangmanRing *ring) {
+    if (__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&ring->running, 0, __ATOMIC_RELEASE);
+        (void)pthread_join(ring->thread, NULL);
+    }
+}
+
+void *ringReserve(struct hangmanRing *ring, unsigned int *pos) {
+    unsigned int next = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    while (1) {
+        unsigned int *seq = sequence(ring, next);
+        int diff = (int)(__atomic_load_n(seq, __ATOMIC_ACQUIRE) - next);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->tail, &next, next + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos = next;
+                return (char *)seq + RING_HEADER;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);      // Full, drop instead of blocking
+            return NULL;
+        } else {
+            next = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void ringPublish(struct hangmanRing *ring, unsigned int pos) {
+    __atomic_store_n(sequence(ring, pos), pos + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file hangman-ring.h
+ * @brief Lock-free record ring of hangman-server for the log and the trace. Request threads
+ *        reserve a slot, fill in a fixed-size record and publish it; a background thread hands
+ *        the published records to a consumer in order. A record the ring has no room for is
+ *        counted as dropped instead of blocking the request
+ */
+#ifndef HANGMAN_RING_H
+#define HANGMAN_RING_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+struct hangmanRing;
+
+/**
+ * Takes one published record, called by the background thread in ring order
+ */
+typedef void (*hangmanRingConsume)(struct hangmanRing *ring, void *record);
+
+/**
+ * Called by the background thread after every pass over the ring, NULL if not needed
+ */
+typedef void (*hangmanRingBatch)(struct hangmanRing *ring, int count);
+
+struct hangmanRing {
+    char *slots; // Sequence and record of every slot
+    size_t slotSize;
+    unsigned int capacity; // Power of two
+    unsigned int tail; // Next position to reserve (request threads)
+    unsigned int head; // Next position to consume (background thread)
+    unsigned long dropped; // Records lost to a full ring
+    long interval; // ns the background thread sleeps when the ring is empty
+    int running;
+    hangmanRingConsume consume;
+    hangmanRingBatch batch;
+    pthread_t thread;
+};
+
+/**
+ * Allocates an empty ring
+ * @param  ring       Ring to initialize
+ * @param  capacity   Number of slots, a power of two
+ * @param  recordSize Size of a record
+ * @param  interval   ns the background thread sleeps when the ring is empty
+ * @param  consume    Consumer of the records
+ * @param  batch      Called after every pass over the ring, NULL for none
+ * @return            0 on success, -1 if out of memory
+ */
+int ringInit(struct hangmanRing *ring, unsigned int capacity, size_t recordSize, long interval,
+             hangmanRingConsume consume, hangmanRingBatch batch);
+
+/**
+ * Frees the slots of a ring without a background thread, no request thread may use it any longer
+ * @param ring Ring
+ */
+void ringFree(struct hangmanRing *ring);
+
+/**
+ * Starts the background thread
+ * @param  ring Ring
+ * @return      0 on success, -1 if the thread can not be started
+ */
+int ringStart(struct hangmanRing *ring);
+
+/**
+ * Hands the remaining records to the consumer and stops the background thread. Request threads
+ * may still reserve slots afterwards, so the slots stay allocated
+ * @param ring Ring
+ */
+void ringStop(struct hangmanRing *ring);
+
+/**
+ * Reserves the slot of the next record, never blocks
+ * @param  ring Ring
+ * @param  pos  Receives the position to publish
+ * @return      The record to fill in, NULL if the ring is full and the record was dropped
+ */
+void *ringReserve(struct hangmanRing *ring, unsigned int *pos);
+
+/**
+ * Publishes a filled in record
+ * @param ring Ring
+ * @param pos  Position from ringReserve
+ */
+void ringPublish(struct hangmanRing *ring, unsigned int pos);
+
+#endif
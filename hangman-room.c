@@ -0,0 +1,119 @@
+/**
+ * @file hangman-room.c
+ * @brief Shared page of the room mode of hangman-server
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hangman-room.h"
+#include "hangman-futex.h"
+
+struct hangmanRoomShm *roomMap(const char *name, int create) {
+    struct stat st;
+    int fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDWR, PERMISSION);
+
+    if (fd == -1) {
+        return NULL;
+    }
+
+    // Spectators write sleepers, so they map the page writable as well
+    if ((create && ftruncate(fd, sizeof(struct hangmanRoomShm)) == -1) || fstat(fd, &st) == -1 ||
+        (size_t)st.st_size < sizeof(struct hangmanRoomShm)) {
+        (void)close(fd);
+        return NULL;
+    }
+
+    void *mapping = mmap(NULL, sizeof(struct hangmanRoomShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    struct hangmanRoomShm *room = (struct hangmanRoomShm *)mapping;
+
+    if (create) {
+        memset(room, 0, sizeof(*room));
+        room->server = (int32_t)getpid();
+        room->started = processStarted(room->server);
+    } else if (__atomic_load_n(&room->magic, __ATOMIC_ACQUIRE) != ROOM_MAGIC) {
+        roomUnmap(room);
+        return NULL;
+    }
+
+    return room;
+}
+
+void roomUnmap(struct hangmanRoomShm *room) {
+    (void)munmap(room, sizeof(struct hangmanRoomShm));
+}
+
+void roomPublish(struct hangmanRoomShm *room, const struct hangmanRoomState *state) {
+    uint32_t seq = __atomic_load_n(&room->seq, __ATOMIC_RELAXED);
+
+    // Odd before any byte of the state changes
+    __atomic_store_n(&room->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    (void)memcpy(&room->state, state, sizeof(*state));
+
+    __atomic_store_n(&room->seq, seq + 2, __ATOMIC_RELEASE);
+
+    if (seq == 0) {
+        __atomic_store_n(&room->magic, ROOM_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    // Pairs with the fence of roomWait, either the sleeper sees the new sequence or the server sees the sleeper
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&room->sleepers, __ATOMIC_RELAXED) != 0) {
+        (void)futexWake(&room->seq, INT_MAX);
+    }
+}
+
+unsigned int roomRead(const struct hangmanRoomShm *room, struct hangmanRoomState *state, uint32_t *seq) {
+    unsigned int retries = 0;
+
+    while (1) {
+        uint32_t before = __atomic_load_n(&room->seq, __ATOMIC_ACQUIRE);
+
+        if ((before & 1) == 0) {
+            (void)memcpy(state, &room->state, sizeof(*state));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            if (__atomic_load_n(&room->seq, __ATOMIC_RELAXED) == before) {
+                *seq = before;
+                return retries;
+            }
+        }
+
+        retries++;
+        eventPause();
+    }
+}
+
+int roomWait(struct hangmanRoomShm *room, uint32_t seen, const struct timespec *timeout) {
+    int result = 0;
+
+    if (__atomic_load_n(&room->seq, __ATOMIC_ACQUIRE) != seen) {
+        return 0;
+    }
+
+    (void)__atomic_add_fetch(&room->sleepers, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // A state published in between changed the word, the wait returns right away
+    if (futexWait(&room->seq, seen, timeout) == -1 && errno != EAGAIN) {
+        result = -1;
+    }
+
+    (void)__atomic_sub_fetch(&room->sleepers, 1, __ATOMIC_RELAXED);
+
+    return result;
+}
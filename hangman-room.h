@@ -0,0 +1,88 @@
+/**
+ * @file hangman-room.h
+ * @brief Shared page of the room mode of hangman-server, where every player guesses the same word.
+ *        The server publishes the state of the room under a sequence lock: it makes the sequence
+ *        odd, writes the state and makes it even again. Spectators copy the state and retry if the
+ *        sequence was odd or changed meanwhile, they never write the cache lines the server writes
+ *        and the server never waits for them. Spectators without news sleep on the sequence
+ */
+#ifndef HANGMAN_ROOM_H
+#define HANGMAN_ROOM_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "hangman-proto.h"
+
+#define ROOM_NAME  "/hangmanRoom"
+#define ROOM_MAGIC 0x4d525248u // "HRRM"
+
+/**
+ * Everything a spectator sees of the room
+ */
+struct hangmanRoomState {
+    uint32_t round; // Number of the current word, 0 before the first round
+    int32_t index; // Word index of the round
+    uint32_t guessedMask; // Bit n is set if letter 'A' + n was guessed
+    uint32_t players; // Clients that joined the round
+    uint32_t guesses; // Letters applied in the round
+    int32_t last; // ID of the client whose letter was applied last, 0 if none
+    int16_t status; // 2 while the round runs, 0 once it is won or lost
+    int16_t wrongGuesses; // Stage of the drawing, 9 if the round is lost
+    uint32_t won; // Rounds won since the server started
+    uint32_t lost;
+    char word[MAX_WORD_LENGTH]; // Revealed letters and _, the whole word once the round is over
+};
+
+/**
+ * The shared page, written by the server only except for sleepers
+ */
+struct hangmanRoomShm {
+    uint32_t magic; // ROOM_MAGIC once the first state is published
+    int32_t server; // pid of the server
+    uint64_t started; // processStarted of the server
+    uint32_t sleepers __attribute__((aligned(64))); // Spectators in futex wait, the server skips the wake if 0
+    uint32_t seq __attribute__((aligned(64))); // Odd while the state is written, also the futex word
+    struct hangmanRoomState state;
+};
+
+/**
+ * Maps the page of a room
+ * @param  name   Name of the segment, ROOM_NAME with the instance appended
+ * @param  create 1 to create and clear it (server), 0 to map an existing one (spectators)
+ * @return        The page, NULL if it does not exist or can not be mapped
+ */
+struct hangmanRoomShm *roomMap(const char *name, int create);
+
+/**
+ * Unmaps the page of a room
+ * @param room Page
+ */
+void roomUnmap(struct hangmanRoomShm *room);
+
+/**
+ * Publishes a new state and wakes sleeping spectators, callers serialize among themselves
+ * @param room  Page
+ * @param state New state
+ */
+void roomPublish(struct hangmanRoomShm *room, const struct hangmanRoomState *state);
+
+/**
+ * Copies a consistent state without taking a lock
+ * @param  room  Page
+ * @param  state Receives the state
+ * @param  seq   Receives the sequence the state belongs to
+ * @return       Number of retries because the server was writing
+ */
+unsigned int roomRead(const struct hangmanRoomShm *room, struct hangmanRoomState *state, uint32_t *seq);
+
+/**
+ * Sleeps until a state newer than the one seen is published
+ * @param  room    Page
+ * @param  seen    Sequence of the last state read
+ * @param  timeout Relative timeout, NULL to wait forever
+ * @return         0 once a newer state is there, -1 on an error (ETIMEDOUT, EINTR)
+ */
+int roomWait(struct hangmanRoomShm *room, uint32_t seen, const struct timespec *timeout);
+
+#endif
@@ -0,0 +1,472 @@
+/**
+ * @file hangman-select.c
+ * @brief Word selection of hangman-server, difficulty scores, buckets and alias tables
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "hangman-select.h"
+
+#define SCORE_ONE       256 // Fixed point scores, 8 fractional bits
+#define SCORE_LIMIT     (48 * SCORE_ONE) // Scores are clamped below
+#define SCORE_DISTINCT  (4 * SCORE_ONE) // Weight of few distinct letters against rare letters
+#define SELECT_TRIES    16 // Draws before the seen bits are searched for a free one
+
+/**
+ * Base 2 logarithm in fixed point, linear between powers of two
+ * @param  x Positive number
+ * @return   log2(x) * SCORE_ONE
+ */
+static uint32_t log2Fixed(uint32_t x) {
+    uint32_t exponent = 31 - (uint32_t)__builtin_clz(x);
+    uint32_t fraction = exponent >= 8 ? (x >> (exponent - 8)) & 0xff : (x << (8 - exponent)) & 0xff;
+
+    return exponent * SCORE_ONE + fraction;
+}
+
+/**
+ * Number in [0, n) from 32 random bits
+ */
+static uint32_t below(uint64_t random, uint32_t n) {
+    return (uint32_t)(((random >> 32) * n) >> 32);
+}
+
+/**
+ * Builds an alias table over buckets (Vose), columns with weight 0 are left out
+ * @param  weights Weight of every bucket
+ * @param  count   Number of buckets
+ * @param  table   Receives the columns, NULL if every weight is 0
+ * @return         Number of columns, -1 if out of memory
+ */
+static int aliasBuild(const double *weights, size_t count, struct hangmanColumn **table) {
+    uint32_t *buckets = (uint32_t *)malloc(count * sizeof(uint32_t));
+    double *scaled = (double *)malloc(count * sizeof(double));
+    uint32_t *small = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint32_t *large = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint32_t columns = 0, smalls = 0, larges = 0;
+    double total = 0;
+
+    *table = NULL;
+
+    if (buckets == NULL || scaled == NULL || small == NULL || large == NULL) {
+        free(buckets);
+        free(scaled);
+        free(small);
+        free(large);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (weights[i] > 0) {
+            buckets[columns++] = (uint32_t)i;
+            total += weights[i];
+        }
+    }
+
+    if (columns > 0) {
+        *table = (struct hangmanColumn *)malloc(columns * sizeof(struct hangmanColumn));
+    }
+
+    if (columns > 0 && *table != NULL) {
+        // Column c starts with bucket c, the average scaled weight is 1
+        for (uint32_t c = 0; c < columns; c++) {
+            scaled[c] = weights[buckets[c]] * columns / total;
+
+            if (scaled[c] < 1) {
+                small[smalls++] = c;
+            } else {
+                large[larges++] = c;
+            }
+        }
+
+        while (smalls > 0 && larges > 0) {
+            uint32_t less = small[--smalls];
+            uint32_t more = large[--larges];
+
+            (*table)[less].bucket = buckets[less];
+            (*table)[less].alias = buckets[more];
+            (*table)[less].threshold = (uint64_t)(scaled[less] * 4294967296.0);
+
+            scaled[more] -= 1 - scaled[less];
+
+            if (scaled[more] < 1) {
+                small[smalls++] = more;
+            } else {
+                large[larges++] = more;
+            }
+        }
+
+        // Left over columns are full, up to rounding
+        while (smalls > 0 || larges > 0) {
+            uint32_t full = smalls > 0 ? small[--smalls] : large[--larges];
+
+            (*table)[full].bucket = buckets[full];
+            (*table)[full].alias = buckets[full];
+            (*table)[full].threshold = (uint64_t)1 << 32;
+        }
+    }
+
+    free(buckets);
+    free(scaled);
+    free(small);
+    free(large);
+
+    return columns > 0 && *table == NULL ? -1 : (int)columns;
+}
+
+/**
+ * Difficulty bands of all words, equally large up to words with the same score
+ * @param  words Word store
+ * @param  bands Receives the band of every word, 0 is the easiest
+ * @return       0 on success, -1 if out of memory
+ */
+static int scoreWords(const struct hangmanWords *words, uint8_t *bands) {
+    uint32_t containing[26] = { 0 };
+    uint32_t rarity[26];
+    uint16_t *scores = (uint16_t *)malloc(words->count * sizeof(uint16_t));
+    uint32_t *histogram = (uint32_t *)calloc(SCORE_LIMIT, sizeof(uint32_t));
+
+    if (scores == NULL || histogram == NULL) {
+        free(scores);
+        free(histogram);
+        return -1;
+    }
+
+    for (size_t i = 0; i < words->count; i++) {
+        for (uint32_t mask = words->mask[i] & WORDS_LETTERS; mask != 0; mask &= mask - 1) {
+            containing[__builtin_ctz(mask)]++;
+        }
+    }
+
+    // Bits of information in a hit on the letter
+    for (int letter = 0; letter < 26; letter++) {
+        rarity[letter] = containing[letter] > 0 ? log2Fixed((uint32_t)words->count) - log2Fixed(containing[letter]) : 0;
+    }
+
+    for (size_t i = 0; i < words->count; i++) {
+        uint32_t letters = words->mask[i] & WORDS_LETTERS;
+        uint32_t distinct = (uint32_t)__builtin_popcount(letters);
+        uint32_t score = 0;
+
+        for (uint32_t mask = letters; mask != 0; mask &= mask - 1) {
+            score += rarity[__builtin_ctz(mask)];
+        }
+
+        score = distinct > 0 ? (score + SCORE_DISTINCT) / distinct : SCORE_LIMIT - 1;
+        scores[i] = (uint16_t)(score < SCORE_LIMIT ? score : SCORE_LIMIT - 1);
+        histogram[scores[i]]++;
+    }
+
+    // Band of a score by the number of easier words
+    for (uint32_t score = 0, easier = 0; score < SCORE_LIMIT; score++) {
+        uint32_t count = histogram[score];
+
+        histogram[score] = (uint32_t)((uint64_t)easier * DIFFICULTY_BANDS / words->count);
+        easier += count;
+    }
+
+    for (size_t i = 0; i < words->count; i++) {
+        bands[i] = (uint8_t)histogram[scores[i]];
+    }
+
+    free(scores);
+    free(histogram);
+
+    return 0;
+}
+
+int indexBuild(struct hangmanIndex *index, const struct hangmanWords *words) {
+    double weights[SELECT_BUCKETS];
+    uint32_t lengths[SELECT_SCOPES][MAX_WORD_LENGTH];
+    uint8_t *bands = (uint8_t *)malloc(words->count > 0 ? words->count : 1);
+
+    memset(index, 0, sizeof(*index));
+    index->order = (uint32_t *)malloc((words->count > 0 ? words->count : 1) * sizeof(uint32_t));
+
+    if (bands == NULL || index->order == NULL || scoreWords(words, bands) == -1) {
+        free(bands);
+        indexFree(index);
+        return -1;
+    }
+
+    // Counting sort by bucket, a word too long for any bucket can only come from a damaged
+    // dictionary and is left out; the game checks the others with wordValid when it draws them
+    for (size_t i = 0; i < words->count; i++) {
+        if (words->length[i] < MAX_WORD_LENGTH) {
+            index->start[bands[i] * MAX_WORD_LENGTH + words->length[i] + 1]++;
+        }
+    }
+
+    for (size_t bucket = 0; bucket < SELECT_BUCKETS; bucket++) {
+        index->start[bucket + 1] += index->start[bucket];
+    }
+
+    for (size_t i = 0; i < words->count; i++) {
+        if (words->length[i] >= MAX_WORD_LENGTH) {
+            continue;
+        }
+
+        uint32_t bucket = bands[i] * MAX_WORD_LENGTH + words->length[i];
+        index->order[index->start[bucket]++] = (uint32_t)i;
+    }
+
+    // The fill moved every start to the start of the next bucket
+    memmove(&index->start[1], &index->start[0], SELECT_BUCKETS * sizeof(uint32_t));
+    index->start[0] = 0;
+    free(bands);
+
+    memset(lengths, 0, sizeof(lengths));
+
+    for (uint32_t bucket = 0; bucket < SELECT_BUCKETS; bucket++) {
+        uint32_t size = index->start[bucket + 1] - index->start[bucket];
+
+        lengths[bucket / MAX_WORD_LENGTH][bucket % MAX_WORD_LENGTH] += size;
+        lengths[DIFFICULTY_BANDS][bucket % MAX_WORD_LENGTH] += size;
+    }
+
+    for (int policy = SELECT_RANDOM; policy < SELECT_POLICIES; policy++) {
+        for (uint32_t scope = 0; scope < SELECT_SCOPES; scope++) {
+            for (uint32_t bucket = 0; bucket < SELECT_BUCKETS; bucket++) {
+                uint32_t size = index->start[bucket + 1] - index->start[bucket];
+                uint32_t length = bucket % MAX_WORD_LENGTH;
+
+                if (size == 0 || (scope < DIFFICULTY_BANDS && bucket / MAX_WORD_LENGTH != scope)) {
+                    weights[bucket] = 0;
+                } else if (policy == SELECT_LENGTH) {
+                    weights[bucket] = (double)size / lengths[scope][length];
+                } else {
+                    weights[bucket] = size;
+                }
+            }
+
+            int columns = aliasBuild(weights, SELECT_BUCKETS, &index->alias[policy][scope]);
+
+            if (columns == -1) {
+                indexFree(index);
+                return -1;
+            }
+
+            index->columns[policy][scope] = (uint32_t)columns;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Offset of the columns in a stored index
+ */
+static size_t storedHead(void) {
+    return (sizeof(struct hangmanStoredIndex) + 7) & ~(size_t)7;
+}
+
+size_t indexStoredSize(const struct hangmanIndex *index) {
+    size_t size = storedHead() + index->start[SELECT_BUCKETS] * sizeof(uint32_t);
+
+    for (int policy = 0; policy < SELECT_POLICIES; policy++) {
+        for (int scope = 0; scope < SELECT_SCOPES; scope++) {
+            size += index->columns[policy][scope] * sizeof(struct hangmanColumn);
+        }
+    }
+
+    return size;
+}
+
+void indexStore(const struct hangmanIndex *index, void *buffer) {
+    struct hangmanStoredIndex *stored = (struct hangmanStoredIndex *)buffer;
+    char *next = (char *)buffer + storedHead();
+
+    memset(buffer, 0, storedHead());
+    stored->count = index->start[SELECT_BUCKETS];
+    (void)memcpy(stored->start, index->start, sizeof(stored->start));
+    (void)memcpy(stored->columns, index->columns, sizeof(stored->columns));
+
+    for (int policy = 0; policy < SELECT_POLICIES; policy++) {
+        for (int scope = 0; scope < SELECT_SCOPES; scope++) {
+            size_t size = index->columns[policy][scope] * sizeof(struct hangmanColumn);
+
+            if (size > 0) {
+                (void)memcpy(next, index->alias[policy][scope], size);
+                next += size;
+            }
+        }
+    }
+
+    (void)memcpy(next, index->order, stored->count * sizeof(uint32_t));
+}
+
+/**
+ * Checks that a column of a stored index only draws from buckets with words in its scope,
+ * selectWord relies on that for its ranges
+ * @param  stored Stored index
+ * @param  scope  Scope of the column
+ * @param  column Column
+ * @return        1 if the column is valid, 0 otherwise
+ */
+static int columnValid(const struct hangmanStoredIndex *stored, uint32_t scope, const struct hangmanColumn *column) {
+    uint32_t buckets[2] = { column->bucket, column->alias };
+
+    if (column->threshold > (uint64_t)1 << 32) {
+        return 0;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (buckets[i] >= SELECT_BUCKETS || stored->start[buckets[i] + 1] <= stored->start[buckets[i]] ||
+            (scope < DIFFICULTY_BANDS && buckets[i] / MAX_WORD_LENGTH != scope)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Checks a stored index against its size, in O(buckets)
+ * @param  stored Stored index
+ * @param  size   Size of the section
+ * @return        1 if the index is valid, 0 otherwise
+ */
+static int storedValid(const struct hangmanStoredIndex *stored, size_t size) {
+    size_t used = storedHead();
+
+    if (size < used || stored->start[0] != 0 || stored->start[SELECT_BUCKETS] != stored->count) {
+        return 0;
+    }
+
+    for (size_t bucket = 0; bucket < SELECT_BUCKETS; bucket++) {
+        if (stored->start[bucket + 1] < stored->start[bucket]) {
+            return 0;
+        }
+    }
+
+    for (int policy = 0; policy < SELECT_POLICIES; policy++) {
+        for (uint32_t scope = 0; scope < SELECT_SCOPES; scope++) {
+            uint32_t columns = stored->columns[policy][scope];
+            const struct hangmanColumn *column = (const struct hangmanColumn *)((const char *)stored + used);
+
+            if (columns > SELECT_BUCKETS || (policy == SELECT_ORDER && columns > 0) ||
+                (size - used) / sizeof(struct hangmanColumn) < columns) {
+                return 0;
+            }
+
+            for (uint32_t c = 0; c < columns; c++) {
+                if (!columnValid(stored, scope, &column[c])) {
+                    return 0;
+                }
+            }
+
+            used += columns * sizeof(struct hangmanColumn);
+        }
+    }
+
+    return (size - used) / sizeof(uint32_t) >= stored->count;
+}
+
+int indexMap(struct hangmanIndex *index, const struct hangmanWords *words) {
+    const struct hangmanStoredIndex *stored = (const struct hangmanStoredIndex *)words->index;
+
+    memset(index, 0, sizeof(*index));
+
+    if (stored == NULL || !storedValid(stored, words->indexSize)) {
+        return -1;
+    }
+
+    char *next = (char *)words->index + storedHead();
+
+    (void)memcpy(index->start, stored->start, sizeof(index->start));
+    (void)memcpy(index->columns, stored->columns, sizeof(index->columns));
+
+    // The mapping is read-only, the index never writes through these pointers
+    for (int policy = 0; policy < SELECT_POLICIES; policy++) {
+        for (int scope = 0; scope < SELECT_SCOPES; scope++) {
+            if (index->columns[policy][scope] > 0) {
+                index->alias[policy][scope] = (struct hangmanColumn *)next;
+                next += index->columns[policy][scope] * sizeof(struct hangmanColumn);
+            }
+        }
+    }
+
+    index->order = (uint32_t *)next;
+    index->mapped = 1;
+
+    return 0;
+}
+
+void indexFree(struct hangmanIndex *index) {
+    if (index->mapped) {
+        memset(index, 0, sizeof(*index));
+        return;
+    }
+
+    free(index->order);
+    index->order = NULL;
+
+    for (int policy = 0; policy < SELECT_POLICIES; policy++) {
+        for (int scope = 0; scope < SELECT_SCOPES; scope++) {
+            free(index->alias[policy][scope]);
+            index->alias[policy][scope] = NULL;
+            index->columns[policy][scope] = 0;
+        }
+    }
+}
+
+int selectWord(const struct hangmanIndex *index, int policy, int band, uint32_t generation, struct hangmanSeen *seen, uint64_t *random) {
+    uint32_t scope = DIFFICULTY_BANDS;
+
+    if (band >= 1 && band <= DIFFICULTY_BANDS && index->columns[policy][band - 1] > 0) {
+        scope = (uint32_t)band - 1;
+    }
+
+    uint32_t columns = index->columns[policy][scope];
+
+    if (columns == 0) {
+        return -1;
+    }
+
+    // Bands are consecutive in order
+    uint32_t first = scope < DIFFICULTY_BANDS ? index->start[scope * MAX_WORD_LENGTH] : 0;
+    uint32_t size = (scope < DIFFICULTY_BANDS ? index->start[(scope + 1) * MAX_WORD_LENGTH] : index->start[SELECT_BUCKETS]) - first;
+    uint32_t slots = size < SEEN_BITS ? size : SEEN_BITS;
+    uint32_t key = generation * SELECT_SCOPES + scope + 1;
+
+    // A new pool or every word seen, start over; switching bands or a reload forgets the words seen
+    if (seen->key != key || seen->drawn >= slots) {
+        memset(seen->bits, 0, sizeof(seen->bits));
+        seen->key = key;
+        seen->drawn = 0;
+    }
+
+    uint32_t position = 0, slot = 0;
+    int found = 0;
+
+    for (int i = 0; i < SELECT_TRIES && !found; i++) {
+        uint64_t draw = selectRandom(random);
+        const struct hangmanColumn *column = &index->alias[policy][scope][below(draw, columns)];
+        uint32_t bucket = (draw & UINT32_MAX) < column->threshold ? column->bucket : column->alias;
+        uint32_t start = index->start[bucket];
+
+        position = start + below(selectRandom(random), index->start[bucket + 1] - start);
+        slot = (position - first) % slots;
+        found = (seen->bits[slot / 64] & (uint64_t)1 << (slot % 64)) == 0;
+    }
+
+    if (!found) {
+        // Nearly exhausted, takes the next free bit after a random one and a word it covers
+        uint32_t from = below(selectRandom(random), slots);
+
+        for (uint32_t i = 0; i <= slots; i++) {
+            slot = (from + i) % slots;
+
+            if ((seen->bits[slot / 64] & (uint64_t)1 << (slot % 64)) == 0) {
+                break;
+            }
+        }
+
+        position = first + slot + slots * below(selectRandom(random), (size - slot + slots - 1) / slots);
+    }
+
+    seen->bits[slot / 64] |= (uint64_t)1 << (slot % 64);
+    seen->drawn++;
+
+    return (int)index->order[position];
+}
@@ -0,0 +1,125 @@
+/**
+ * @file hangman-select.h
+ * @brief Word selection of hangman-server. An index built at load time sorts the words into
+ *        buckets by difficulty band and length, alias tables over the buckets draw a word in
+ *        O(1) for every policy and band
+ */
+#ifndef HANGMAN_SELECT_H
+#define HANGMAN_SELECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hangman-words.h"
+
+#define SELECT_BUCKETS (DIFFICULTY_BANDS * MAX_WORD_LENGTH) // Bucket of a word: band * MAX_WORD_LENGTH + length
+#define SELECT_SCOPES  (DIFFICULTY_BANDS + 1) // One per band, the last one covers every band
+#define SEEN_BITS      4096 // Words a session remembers, a larger pool maps several words to each bit
+
+enum hangmanPolicy {
+    SELECT_ORDER, // Words in file order
+    SELECT_RANDOM, // Every word equally likely
+    SELECT_LENGTH, // Every word length equally likely, words of one length equally likely
+    SELECT_POLICIES
+};
+
+/**
+ * Column of an alias table, keeps its own bucket with probability threshold / 2^32
+ */
+struct hangmanColumn {
+    uint32_t bucket;
+    uint32_t alias;
+    uint64_t threshold;
+};
+
+struct hangmanIndex {
+    uint32_t *order; // Word indices sorted by bucket
+    uint32_t start[SELECT_BUCKETS + 1]; // Range of every bucket in order
+    struct hangmanColumn *alias[SELECT_POLICIES][SELECT_SCOPES]; // NULL for SELECT_ORDER
+    uint32_t columns[SELECT_POLICIES][SELECT_SCOPES]; // 0 if the scope has no words
+    int mapped; // order and alias point into a compiled dictionary
+};
+
+/**
+ * Head of an index stored in a compiled dictionary, followed by the columns of every policy
+ * and scope in order and by order[count]
+ */
+struct hangmanStoredIndex {
+    uint32_t count; // Words in order
+    uint32_t start[SELECT_BUCKETS + 1];
+    uint32_t columns[SELECT_POLICIES][SELECT_SCOPES];
+};
+
+/**
+ * Words a session already got, reset when the pool is exhausted or changes
+ */
+struct hangmanSeen {
+    uint32_t key; // Generation of the store and scope the bits belong to, 0 if unused
+    uint32_t drawn; // Bits set
+    uint64_t bits[SEEN_BITS / 64]; // Bit n covers the words at positions n, n + slots, ... of the scope
+};
+
+/**
+ * Scores the words and builds the buckets and alias tables, harder words have rarer letters
+ * and fewer distinct letters. The bands split the words into equally large parts
+ * @param  index Index to build, zeroed or freed
+ * @param  words Word store
+ * @return       0 on success, -1 if out of memory
+ */
+int indexBuild(struct hangmanIndex *index, const struct hangmanWords *words);
+
+/**
+ * Size of an index stored by indexStore
+ * @param  index Built index
+ * @return       Size in bytes
+ */
+size_t indexStoredSize(const struct hangmanIndex *index);
+
+/**
+ * Stores an index for a compiled dictionary, hangman-wordc builds it once so the server does not
+ * @param index  Built index
+ * @param buffer Receives indexStoredSize bytes, aligned to 8
+ */
+void indexStore(const struct hangmanIndex *index, void *buffer);
+
+/**
+ * Uses the index stored in a compiled dictionary in place, in O(buckets). The bucket ranges and
+ * the columns are checked here, the word indices when the game draws them
+ * @param  index Index to set up, zeroed or freed
+ * @param  words Mapped word store
+ * @return       0 on success, -1 if the store has no index or it is damaged
+ */
+int indexMap(struct hangmanIndex *index, const struct hangmanWords *words);
+
+/**
+ * Frees an index, a zeroed index is left alone
+ * @param index Index
+ */
+void indexFree(struct hangmanIndex *index);
+
+/**
+ * Draws a word the session did not get since its pool was last exhausted, in O(1)
+ * @param  index      Index of the word store
+ * @param  policy     SELECT_RANDOM or SELECT_LENGTH
+ * @param  band       Difficulty band, 1 (easy) to DIFFICULTY_BANDS, 0 or an empty band for any
+ * @param  generation Generation of the word store
+ * @param  seen       Words the session got
+ * @param  random     State of the random generator, not 0
+ * @return            Index of the word, -1 if the store is empty
+ */
+int selectWord(const struct hangmanIndex *index, int policy, int band, uint32_t generation, struct hangmanSeen *seen, uint64_t *random);
+
+/**
+ * Next number of a xorshift64* generator
+ * @param  state State, not 0
+ * @return       Random number
+ */
+static inline uint64_t selectRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 2685821657736338717ull;
+}
+
+#endif
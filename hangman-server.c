@@ -5,168 +5,464 @@
  * @brief The hangman server. Manages games from hangmna clients
  */
 #include "hangman.h"
+#include "hangman-dict.h"
+#include "hangman-game.h"
+#include "hangman-log.h"
+#include "hangman-players.h"
+#include "hangman-registry.h"
+#include "hangman-room.h"
+#include "hangman-trace.h"
+#include "hangman-words.h"
+
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define DEFAULT_MAX_SESSIONS 4096
+#define MAX_WORKERS          64
+#define MAX_EVENTS           256
+#define LISTENER             UINT64_MAX // epoll data of the listening socket
+#define DEFAULT_SPIN         1000 // Spin limit of -w futex
+#define REAP_INTERVAL        1000000000u // ns between looks for slots of dead clients, also between ticks of the idle timers
+#define DEFAULT_TIMEOUT      1800 // Seconds until an idle session expires
+#define QUEUE_LENGTH         (2 * MAX_SLOTS + 1) // Each slot has at most one request and one drop queued, plus one tick
 
-char *failureDrawing[10];
-
-char **words;
-int wordCount;
+/**
+ * Request, abandoned slot or tick of the idle timers handed to a worker
+ */
+struct hangmanWork {
+    int slot; // -1 to advance the idle timers
+    int dead; // pid of the dead owner of the slot, 0 to serve a request
+};
 
-struct hangmanList {
-    struct hangmanData data;
-    struct hangmanList *next;
+/**
+ * Sessions of the clients hashed to one worker thread, only that thread touches them
+ */
+struct hangmanShard {
+    struct hangmanGame game;
+    pthread_t thread;
+    struct hangmanEvent wake; // Posted by the dispatcher for every queued request
+    unsigned int head; // Next request to serve (worker)
+    unsigned int tail; // Next free queue entry (dispatcher)
+    int ticking; // A tick is queued, set by the dispatcher and cleared by the worker
+    struct hangmanWork queue[QUEUE_LENGTH];
 };
 
-struct hangmanList *hangmanListHead;
+struct hangmanDicts dicts;
+
+struct hangmanPlayers players; // Mapped if -P is given
+
+char *tracePath = NULL; // Requests are recorded if -T is given
+
+struct hangmanShard *shards;
+int workers = 1;
+
+char transport = TRANSPORT_SHM;
+int listener = -1;
+
+unsigned int admission = ADMISSION_FIFO;
+unsigned int waitMode = WAIT_DEFAULT;
+unsigned int spinLimit = DEFAULT_SPIN;
+
+struct hangmanMetrics *metrics;
+
+struct hangmanRoom room; // Published if -R is given
+
+struct hangmanRegistry registry;
+int owner = 0; // The names below belong to this process, set once it joined the registry or created the semaphores
+
+char shmName[NAME_LENGTH];
+char semClient[NAME_LENGTH];
+char semLocked[NAME_LENGTH];
+char socketPath[NAME_LENGTH];
+char metricsName[NAME_LENGTH];
+char roomName[NAME_LENGTH];
 
 /**
- * Determines how many clients are connected
- * @return  Number of clients
+ * Shard responsible for a client
+ * @param  id ID of the client
+ * @return    The shard
  */
-static int calcClients(void) {
-    if (hangmanListHead == NULL) {
-        return 0;
-    } else {
-        int count = 0;
+static struct hangmanShard *shardOf(int id) {
+    return &shards[(unsigned int)id % (unsigned int)workers];
+}
 
-        for (struct hangmanList *head = hangmanListHead; head != NULL; head = head->next) {
-            count++;
-        }
+/**
+ * Serves the request in a slot and wakes the client
+ * @param game Game of the shard the client belongs to
+ * @param slot Index of the slot
+ */
+static void serve(struct hangmanGame *game, int slot) {
+    struct hangmanData *request = &shm->slots[slot].data;
+    int id = request->id;
+    int status = handleRequest(game, request, request->format == FORMAT_COMPACT ? &shm->slots[slot].compact : NULL);
+
+    if ((waitMode == WAIT_FUTEX ? eventPost(&shm->slots[slot].replied) : sem_post(&shm->slots[slot].reply)) < 0) {
+        bail_out("sem_post(reply)");
+    }
 
-        return count;
+    if (status == -1) {         // Client should be removed
+        removeClient(game, id);
     }
 }
 
 /**
- * Adds a new Client to the list
- * @return ID of the new client
+ * Drops the session of a client that died while owning a slot and frees the slot, the next
+ * waiting client is admitted
+ * @param game Game of the shard the client belongs to
+ * @param slot Index of the slot, its owner is SLOT_RECLAIMING
+ * @param dead pid of the dead client
  */
-static struct hangmanData *addClient(int id) {
-    struct hangmanList *newClient;
+static void reclaim(struct hangmanGame *game, int slot, int dead) {
+    struct hangmanSlot *abandoned = &shm->slots[slot];
 
-    if (hangmanListHead == NULL) {
-        hangmanListHead = (struct hangmanList *)malloc(sizeof(struct hangmanList));
-        newClient = hangmanListHead;
+    if (getClient(game, dead) != NULL) {
+        logWrite(LOG_INFO, LOG_DISCONNECT, dead, -1, '\0', 0);
+        removeClient(game, dead);
+    }
+
+    // Drops replies nobody waits for
+    while (waitMode == WAIT_SEM && sem_trywait(&abandoned->reply) == 0) {
+        // Drain
+    }
+
+    __atomic_store_n(&abandoned->replied.count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&abandoned->owner, SLOT_FREE, __ATOMIC_RELEASE);
+
+    if (admission == ADMISSION_FIFO) {
+        (void)__atomic_add_fetch(&shm->fifo.released, 1, __ATOMIC_RELEASE);
+        (void)futexWake(&shm->fifo.released, 1);
     } else {
-        struct hangmanList *newElem = (struct hangmanList *)malloc(sizeof(struct hangmanList));
-        newElem->next = hangmanListHead->next;
-        hangmanListHead->next = newElem;
-        newClient = newElem;
+        (void)sem_post(locked);
     }
+}
+
+/**
+ * Worker thread, serves the requests queued for its shard
+ * @param  arg The shard
+ * @return     Never returns
+ */
+static void *work(void *arg) {
+    struct hangmanShard *shard = (struct hangmanShard *)arg;
+    unsigned int spin = 0; // The dispatcher posts rarely enough to sleep right away
+
+    while (1) {
+        if (eventWait(&shard->wake, &spin, 0, NULL) < 0) {
+            continue;
+        }
+
+        const struct hangmanWork *next = &shard->queue[shard->head % QUEUE_LENGTH];
 
-    if (newClient != NULL) {
-        newClient->data.id = id;
-        newClient->data.status = 0;
-        newClient->data.wrongGuesses = 0;
-        newClient->data.index = -1;
-        newClient->data.clientW = 0;
-        newClient->data.clientL = 0;
-        memset(&newClient->data.word, 0, sizeof(newClient->data.word));
-        memset(&newClient->data.info, 0, sizeof(newClient->data.info));
-        memset(&newClient->data.guessed, '_', sizeof(newClient->data.guessed));
+        if (next->slot < 0) {
+            gameTick(&shard->game);
+            __atomic_store_n(&shard->ticking, 0, __ATOMIC_RELEASE);
+        } else if (next->dead != 0) {
+            reclaim(&shard->game, next->slot, next->dead);
+        } else {
+            serve(&shard->game, next->slot);
+        }
 
-        return &newClient->data;
+        shard->head++;
     }
 
     return NULL;
 }
 
 /**
- * Returns the clients data from the list
- * @param  id ID obtained by the client
- * @return    hangmanData for specified ID
+ * Serves a request or reclaims a slot right away, or hands it to the worker of the client
+ * @param slot Index of the slot
+ * @param dead pid of the dead owner of the slot, 0 to serve the request in it
  */
-static struct hangmanData *getClient(int id) {
-    if (hangmanListHead == NULL) {
-        return NULL;
+static void dispatch(int slot, int dead) {
+    struct hangmanShard *shard = shardOf(dead != 0 ? dead : shm->slots[slot].data.id);
+
+    if (workers == 1) {
+        if (dead != 0) {
+            reclaim(&shard->game, slot, dead);
+        } else {
+            serve(&shard->game, slot);
+        }
     } else {
-        for (struct hangmanList *head = hangmanListHead; head != NULL; head = head->next) {
-            if (head->data.id == id) {
-                return &head->data;
-            }
+        shard->queue[shard->tail % QUEUE_LENGTH].slot = slot;
+        shard->queue[shard->tail % QUEUE_LENGTH].dead = dead;
+        shard->tail++;
+
+        if (eventPost(&shard->wake) < 0) {
+            bail_out("eventPost(wake)");
         }
+    }
+}
 
-        return NULL;
+/**
+ * Publishes the sessions of all shards in the registry, clients routing by load read them
+ */
+static void publishLoad(void) {
+    uint32_t sessions = 0;
+
+    for (int i = 0; i < workers; i++) {
+        sessions += (uint32_t)calcClients(&shards[i].game);
     }
+
+    registryUpdate(&registry, sessions);
 }
 
 /**
- * Removes a client from the list
- * @param id ID from the client
+ * Advances the idle timers of every shard, a worker that is still busy with its last tick is
+ * skipped and catches up at its next tick
  */
-static void removeClient(int id) {
-    if (hangmanListHead == NULL) {
+static void tick(void) {
+    if (workers == 1) {
+        gameTick(&shards[0].game);
         return;
-    } else {
-        struct hangmanList *before = NULL;
-
-        for (struct hangmanList *head = hangmanListHead; head != NULL; head = head->next) {
-            if (head->data.id == id) {
-                if (before == NULL) {
-                    hangmanListHead = head->next;
-                } else {
-                    before->next = head->next;
-                }
+    }
 
-                free(head);
-                return;
-            }
+    for (int i = 0; i < workers; i++) {
+        struct hangmanShard *shard = &shards[i];
 
-            before = head;
+        if (__atomic_load_n(&shard->ticking, __ATOMIC_ACQUIRE)) {
+            continue;
         }
 
-        return;
+        shard->ticking = 1;
+        shard->queue[shard->tail % QUEUE_LENGTH].slot = -1;
+        shard->queue[shard->tail % QUEUE_LENGTH].dead = 0;
+        shard->tail++;
+
+        if (eventPost(&shard->wake) < 0) {
+            bail_out("eventPost(wake)");
+        }
     }
 }
 
 /**
- * Reads a file
- * @param file The file to read
+ * Serves all pending requests
  */
-static void readFile(FILE *file);
+static void drain(void) {
+    for (uint64_t pending = pendingTake(shm); pending != 0; pending &= pending - 1) {
+        dispatch(__builtin_ctzll(pending), 0);
+    }
+}
 
 /**
- * Adds a word to the wordlist
- * @param word word to add to the wordlist
+ * Looks for slots whose owner died without releasing them, a client killed at any point of
+ * the protocol can not block the others
  */
-static void addWord(char *word) {
-    if (words == NULL) {
-        wordCount = 1;
-        words = (char **)malloc(sizeof(word) * wordCount);
-    } else {
-        ++wordCount;
-        words = (char **)realloc(words, sizeof(word) * wordCount);
+static void reap(void) {
+    int dead[MAX_SLOTS];
+
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        int owner = __atomic_load_n(&shm->slots[i].owner, __ATOMIC_ACQUIRE);
+
+        dead[i] = 0;
+
+        if (owner > 0 && !processAlive(owner) &&
+            __atomic_compare_exchange_n(&shm->slots[i].owner, &owner, SLOT_RECLAIMING, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            dead[i] = owner;
+        }
     }
 
-    if (words != NULL) {
-        words[wordCount - 1] = (char *)malloc(MAX_WORD_LENGTH * sizeof(char));
-        (void)strcpy(words[wordCount - 1], word);
+    // A request the client left before dying is served first, workers keep the order
+    drain();
 
-        for (size_t i = 0; i < MAX_WORD_LENGTH; i++) {
-            words[wordCount - 1][i] = (char)toupper(words[wordCount - 1][i]);
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        if (dead[i] != 0) {
+            dispatch(i, dead[i]);
         }
+    }
+}
+
+#ifdef __linux__
+/**
+ * Ends the session of a socket connection, the client quit or died
+ * @param game Game of the shard the connection belongs to
+ * @param fd   The connection
+ * @param id   ID of the client, 0 if it never sent a request
+ */
+static void hangUp(struct hangmanGame *game, int fd, int id) {
+    if (id != 0 && getClient(game, id) != NULL) {
+        logWrite(LOG_INFO, LOG_DISCONNECT, id, -1, '\0', 0);
+        removeClient(game, id);
+    }
+
+    (void)close(fd); // Also removes it from the epoll set
+}
+
+/**
+ * Serves one request packet of a socket connection
+ * @param  game   Game of the shard the connection belongs to
+ * @param  fd     The connection
+ * @param  id     ID of the client, 0 for its first request
+ * @param  packet The request, at least up to its letters
+ * @param  length Length of the packet
+ * @return        Status of the client after the request, -1 if it should be removed
+ */
+static int serveSocket(struct hangmanGame *game, int fd, int id, const struct hangmanRequest *packet, ssize_t length) {
+    struct hangmanData request;
+    struct hangmanResponse response;
+
+    request.id = id != 0 ? id : packet->id; // The ID can not change on an open connection
+    request.send = packet->send;
+    request.signal = packet->signal;
+    request.format = FORMAT_COMPACT;
+    request.batch = packet->batch;
+    request.band = (char)packet->band;
+    request.player = packet->player;
+
+    // Never more letters than the packet carries or the request holds
+    if (request.batch > length - (ssize_t)offsetof(struct hangmanRequest, letters)) {
+        request.batch = (short)(length - (ssize_t)offsetof(struct hangmanRequest, letters));
+    }
 
-        (void)strtok(words[wordCount - 1], "\n");
+    if (request.batch > MAX_BATCH) {
+        request.batch = MAX_BATCH;
     }
+
+    (void)memcpy(request.letters, packet->letters, (size_t)request.batch);
+
+    int status = handleRequest(game, &request, &response.reply);
+    size_t size = sizeof(response.reply);
+
+    if (response.reply.flags & REPLY_WORD) {
+        size_t word = strlen(request.word) + 1;
+        (void)memcpy(response.word, request.word, word);
+        size = offsetof(struct hangmanResponse, word) + word;
+    }
+
+    if (send(fd, &response, size, MSG_NOSIGNAL) < 0) {
+        return -1;
+    }
+
+    return status;
 }
 
 /**
- * Replaces _ from a word if a correct letter was guessed
- * @param id    Client ID
- * @param index Index of the word the client is guessing
+ * Event loop of the socket transport, every worker accepts its own connections and keeps
+ * their sessions in its shard
+ * @param  arg The shard
+ * @return     Never returns
  */
-static void clearWord(int id, int index) {
-    long length = strlen(words[index]);
+static void *pollSockets(void *arg) {
+    struct hangmanShard *shard = (struct hangmanShard *)arg;
+    struct epoll_event events[MAX_EVENTS];
+    struct epoll_event event;
+    uint64_t nextTick = metricsNow() + REAP_INTERVAL;
+
+    int epoll = epoll_create(MAX_EVENTS);
+
+    if (epoll == -1) {
+        bail_out("epoll_create");
+    }
+
+    // Only one of the workers is woken for a new connection
+    event.events = workers > 1 ? EPOLLIN | EPOLLEXCLUSIVE : EPOLLIN;
+    event.data.u64 = LISTENER;
 
-    for (size_t i = 0; i < length; i++) {
-        for (size_t j = 0; j < 26; j++) {
-            struct hangmanData *client = getClient(id);
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) == -1) {
+        bail_out("epoll_ctl");
+    }
+
+    while (1) {
+        int ready = epoll_wait(epoll, events, MAX_EVENTS, REAP_INTERVAL / 1000000);
+
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            bail_out("epoll_wait");
+        }
+
+        // Each worker owns the idle timers of its shard
+        if (metricsNow() >= nextTick) {
+            gameTick(&shard->game);
+            nextTick = metricsNow() + REAP_INTERVAL;
+
+            if (shard == &shards[0]) {
+                publishLoad();
+            }
+        }
+
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.u64 == LISTENER) {
+                int fd;
+
+                while ((fd = accept(listener, NULL, NULL)) != -1) {
+                    event.events = EPOLLIN | EPOLLRDHUP;
+                    event.data.u64 = (uint32_t)fd;
+
+                    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+                        (void)close(fd);
+                    }
+                }
+
+                continue;
+            }
+
+            // The ID of the client is kept next to the descriptor once it is known
+            int fd = (int)(uint32_t)events[i].data.u64;
+            int id = (int)(events[i].data.u64 >> 32);
+
+            if (events[i].events & EPOLLIN) {
+                struct hangmanRequest packet;
+                ssize_t length = recv(fd, &packet, sizeof(packet), MSG_DONTWAIT);
+
+                if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+                    continue;
+                }
 
-            if (words[index][i] == client->guessed[j]) {
-                client->word[i] = words[index][i];
+                if (length >= (ssize_t)offsetof(struct hangmanRequest, letters)) {
+                    if (serveSocket(&shard->game, fd, id, &packet, length) == -1) {
+                        // Client should be removed
+                        removeClient(&shard->game, id != 0 ? id : packet.id);
+                        (void)close(fd);
+                    } else if (id == 0) {
+                        event.events = EPOLLIN | EPOLLRDHUP;
+                        event.data.u64 = (uint64_t)(uint32_t)packet.id << 32 | (uint32_t)fd;
+                        (void)epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+                    }
+
+                    continue;
+                }
             }
+
+            hangUp(&shard->game, fd, id);
         }
     }
+
+    return NULL;
+}
+#else
+/**
+ * The socket transport needs epoll, -u is refused elsewhere
+ * @param  arg The shard
+ * @return     NULL
+ */
+static void *pollSockets(void *arg) {
+    (void)arg;
+
+    return NULL;
 }
+#endif
+
+/**
+ * Reads a file, a dictionary compiled by hangman-wordc is mapped instead of parsed
+ * @param file The file to read
+ * @param path Path of the file, NULL for stdin
+ */
+static void readFile(FILE *file, const char *path);
+
+/**
+ * Reloads the words on SIGHUP, the loader thread does the work
+ * @param sig Signal number
+ */
+static void reloadHandler(int sig);
 
 /**
  * Main
@@ -179,8 +475,142 @@ int main(int argc, char *argv[]) {
     progname = argv[0];
     int c;
 
-    while ((c = getopt(argc, argv, "?")) != -1) {
+    long maxSessions = DEFAULT_MAX_SESSIONS;
+    long timeout = DEFAULT_TIMEOUT;
+    int policy = SELECT_RANDOM;
+    int hints = 0;
+    int roomMode = 0;
+    char *playersPath = NULL;
+    unsigned int snapshotInterval = PLAYERS_INTERVAL;
+    int verbosity = LOG_DEBUG;
+    const char *instance = NULL;
+    char *end;
+
+    while ((c = getopt(argc, argv, "a:j:m:n:o:P:RsT:t:uv:w:")) != -1) {
         switch (c) {
+            case 'a':
+                if (strcmp(optarg, "fifo") == 0) {
+                    admission = ADMISSION_FIFO;
+                } else if (strcmp(optarg, "sem") == 0) {
+                    admission = ADMISSION_SEM;
+                } else {
+                    usage();
+                }
+
+                break;
+
+            case 'w':
+                if (strcmp(optarg, "sem") == 0 && WAIT_DEFAULT == WAIT_SEM) {
+                    waitMode = WAIT_SEM;
+                } else if (strncmp(optarg, "futex", 5) == 0 && (optarg[5] == '\0' || optarg[5] == ':')) {
+                    waitMode = WAIT_FUTEX;
+
+                    if (optarg[5] == ':') {
+                        long spin = strtol(optarg + 6, &end, 10);
+
+                        if (*end != '\0' || end == optarg + 6 || spin < 0) {
+                            usage();
+                        }
+
+                        spinLimit = (unsigned int)spin;
+                    }
+                } else {
+                    usage();
+                }
+
+                break;
+
+            case 'u':
+#ifdef __linux__
+                transport = TRANSPORT_SOCKET;
+#else
+                usage();
+#endif
+                break;
+
+            case 'j':
+                workers = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || workers < 1 || workers > MAX_WORKERS) {
+                    usage();
+                }
+
+                break;
+
+            case 'm':
+                maxSessions = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || maxSessions < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 'n':
+                instance = optarg;
+                break;
+
+            case 'o':
+                if (strcmp(optarg, "order") == 0) {
+                    policy = SELECT_ORDER;
+                } else if (strcmp(optarg, "random") == 0) {
+                    policy = SELECT_RANDOM;
+                } else if (strcmp(optarg, "length") == 0) {
+                    policy = SELECT_LENGTH;
+                } else {
+                    usage();
+                }
+
+                break;
+
+            case 'P': {
+                char *colon = strrchr(optarg, ':');
+
+                if (colon != NULL) {
+                    long seconds = strtol(colon + 1, &end, 10);
+
+                    if (*end != '\0' || end == colon + 1 || seconds < 1 || seconds > INT32_MAX) {
+                        usage();
+                    }
+
+                    *colon = '\0';
+                    snapshotInterval = (unsigned int)seconds;
+                }
+
+                playersPath = optarg;
+                break;
+            }
+
+            case 'R':
+                roomMode = 1;
+                break;
+
+            case 's':
+                hints = 1;
+                break;
+
+            case 'T':
+                tracePath = optarg;
+                break;
+
+            case 't':
+                timeout = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || timeout < 0 || timeout > INT32_MAX) {
+                    usage();
+                }
+
+                break;
+
+            case 'v':
+                verbosity = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || verbosity < LOG_OFF || verbosity > LOG_DEBUG) {
+                    usage();
+                }
+
+                break;
+
             case '?':
                 usage();
                 break;
@@ -190,186 +620,363 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (argc > 2) {
+    if (argc - optind > 1) {
+        usage();
+    }
+
+    if (instance == NULL) {
+        instance = instanceDefault() != NULL ? instanceDefault() : "";
+    }
+
+    if (!instanceValid(instance)) {
         usage();
-    } else if (argc == 1) {
-        readFile(stdin);
+    }
+
+    instanceName(shmName, SHM_NAME, instance);
+    instanceName(semClient, SEM_CLIENT, instance);
+    instanceName(semLocked, SEM_LOCKED, instance);
+    instanceName(socketPath, SOCKET_PATH, instance);
+    instanceName(metricsName, METRICS_NAME, instance);
+    instanceName(roomName, ROOM_NAME, instance);
+
+    if (dictsInit(&dicts, argc > optind ? argv[optind] : NULL) == -1) {
+        bail_out("dictsInit");
+    }
+
+    dicts.hints = hints;
+
+    if (argc == optind) {
+        readFile(stdin, NULL);
     } else {
-        FILE *file = fopen(argv[1], "r");
+        FILE *file = fopen(argv[optind], "r");
 
         if (file == NULL) {
             bail_out("Could not read file");
             exit(EXIT_FAILURE);
         } else {
-            readFile(file);
+            readFile(file, argv[optind]);
         }
 
         fclose(file);
     }
 
-    failureDrawing[0] = (char *)"\n\n\n\n\n\n";
-    failureDrawing[1] = (char *)"\n\n\n\n\n/\n";
-    failureDrawing[2] = (char *)"\n\n\n\n\n/ \\\n";
-    failureDrawing[3] = (char *)"\n\n\n\n |\n/ \\\n";
-    failureDrawing[4] = (char *)"\n\n\n |\n |\n/ \\\n";
-    failureDrawing[5] = (char *)"\n\n /\n |\n |\n/ \\\n";
-    failureDrawing[6] = (char *)"\n  /\n /\n |\n |\n/ \\\n";
-    failureDrawing[7] = (char *)"   __\n  /\n /   \n |\n |\n/ \\\n";
-    failureDrawing[8] = (char *)"   __\n  /  |\n /\n |\n |\n/ \\\n";
-    failureDrawing[9] = (char *)"   __\n  /  |\n /   O\n |  /|\\\n |  / \\\n/ \\\n";
+    if (dictBuild(&dicts, dicts.current) == -1) {
+        bail_out("dictBuild");
+    }
+
+    // MARK: Sessions
+
+    shards = (struct hangmanShard *)calloc(workers, sizeof(struct hangmanShard));
+
+    if (shards == NULL) {
+        bail_out("calloc");
+    }
+
+    for (int i = 0; i < workers; i++) {
+        if (gameInit(&shards[i].game, &dicts, (size_t)maxSessions) == -1) {
+            bail_out("gameInit");
+        }
+
+        shards[i].game.timeout = (uint32_t)timeout;
+        shards[i].game.policy = policy;
+    }
+
+    // MARK: Players
+
+    if (playersPath != NULL) {
+        struct timespec start, end;
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if (playersOpen(&players, playersPath, snapshotInterval) == -1) {
+            bail_out("Could not open player file");
+        }
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+        for (int i = 0; i < workers; i++) {
+            shards[i].game.players = &players;
+        }
+
+        (void)printf("Mapped %llu players in %.3f ms\n", (unsigned long long)players.header->count,
+                     (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    }
+
+    // MARK: Registry
+
+    if (registryOpen(&registry, 1) == -1) {
+        (void)fprintf(stderr, "%s: Registry not available, clients have to name the instance\n", progname);
+    } else if (registryJoin(&registry, instance, transport, (uint32_t)(maxSessions * workers)) == -1) {
+        bail_out("Instance already running");
+    } else {
+        owner = 1;
+    }
 
     // MARK: Signal
 
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    signal(SIGHUP, reloadHandler);
+
+    // MARK: Socket
+
+    if (transport == TRANSPORT_SOCKET) {
+        struct sockaddr_un address;
+        struct rlimit files;
+
+        // Every client holds a descriptor
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+            files.rlim_cur = files.rlim_max;
+            (void)setrlimit(RLIMIT_NOFILE, &files);
+        }
+
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        (void)strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+        listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+
+        if (listener == -1) {
+            bail_out("socket");
+        }
+
+        if (bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1) {
+            (void)close(listener);
+            listener = -1;
+            bail_out("bind (SOCKET_PATH)");
+        }
+
+        if (chmod(socketPath, PERMISSION) == -1 || listen(listener, SOMAXCONN) == -1) {
+            bail_out("listen");
+        }
+
+        if (fcntl(listener, F_SETFL, O_NONBLOCK) == -1) {
+            bail_out("fcntl");
+        }
+    }
+
+    if (transport == TRANSPORT_SHM) {
+        // MARK: Semaphore
+
+        // No running server has this name, objects left behind by one that crashed are replaced
+        if (owner) {
+            (void)sem_unlink(semClient);
+            (void)sem_unlink(semLocked);
+        }
+
+        // Without the registry, creating the semaphores exclusively makes the names ours
+        client = sem_open(semClient, O_CREAT | O_EXCL, PERMISSION, 0);
+
+        if (client == SEM_FAILED) {
+            client = NULL;
+            bail_out("sem_open (SEM_CLIENT)");
+        }
+
+        locked = sem_open(semLocked, O_CREAT | O_EXCL, PERMISSION, MAX_SLOTS);
+
+        if (locked == SEM_FAILED) {
+            locked = NULL;
+
+            if (!owner) {
+                (void)sem_unlink(semClient);
+            }
+
+            bail_out("sem_open (SEM_LOCKED)");
+        }
+
+        owner = 1;
+
+        // The semaphores are ours, a segment of the name was left behind by a server that crashed
+        (void)shm_unlink(shmName);
+
+        // MARK: Shared Memory
+
+        int fd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, PERMISSION);
+
+        if (fd == -1) {
+            bail_out("shm_open");
+        }
+
+        if (ftruncate(fd, sizeof(struct hangmanShm)) == -1) {
+            printf("%s\n", "ftruncate");
+        }
+
+        shm = (struct hangmanShm *)mmap(NULL, sizeof(struct hangmanShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (shm == MAP_FAILED) {
+            shm = NULL;
+            bail_out("mmap");
+        }
+
+        if (close(fd) == -1) {
+            bail_out("close");
+        }
+
+        shm->status = 0;
+        shm->server = getpid();
+        shm->pending = 0;
+        shm->wait = waitMode;
+        shm->spin = spinLimit;
+        eventInit(&shm->doorbell);
+        shm->admission = admission;
+        memset(&shm->fifo, 0, sizeof(shm->fifo));
+
+        for (size_t i = 0; i < MAX_SLOTS; i++) {
+            shm->slots[i].owner = SLOT_FREE;
+            eventInit(&shm->slots[i].replied);
+
+#ifdef __linux__
+            if (waitMode == WAIT_SEM && sem_init(&shm->slots[i].reply, 1, 0) == -1) {
+                bail_out("sem_init(reply)");
+            }
+#endif
+        }
+    }
 
-    // MARK: Shared Memory
+    // MARK: Metrics
 
-    int shm = shm_open(SHM_NAME, O_CREAT | O_RDWR, PERMISSION);
+    int fd = shm_open(metricsName, O_CREAT | O_RDWR, PERMISSION);
 
-    if (shm == -1) {
-        bail_out("shm_open");
+    if (fd == -1) {
+        bail_out("shm_open (METRICS_NAME)");
     }
 
-    if (ftruncate(shm, sizeof(struct hangmanData)) == -1) {
-        printf("%s\n", "ftruncate");
+    if (ftruncate(fd, metricsSize(workers)) == -1) {
+        bail_out("ftruncate (METRICS_NAME)");
     }
 
-    shared = (struct hangmanData *)mmap(NULL, sizeof(struct hangmanData), PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+    metrics = (struct hangmanMetrics *)mmap(NULL, metricsSize(workers), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
 
-    if (shared == MAP_FAILED) {
-        bail_out("mmap");
+    if (metrics == MAP_FAILED) {
+        metrics = NULL;
+        bail_out("mmap (METRICS_NAME)");
     }
 
-    if (close(shm) == -1) {
-        bail_out("close");
+    memset(metrics, 0, metricsSize(workers));
+    metrics->workers = (uint32_t)workers;
+    metrics->started = (int64_t)time(NULL);
+
+    for (int i = 0; i < workers; i++) {
+        shards[i].game.metrics = &metrics->shard[i];
     }
 
-    // MARK: Semaphore
+    __atomic_store_n(&metrics->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
 
-    server = sem_open(SEM_SERVER, O_CREAT | O_EXCL, PERMISSION, 0);
-    client = sem_open(SEM_CLIENT, O_CREAT | O_EXCL, PERMISSION, 0);
-    locked = sem_open(SEM_LOCKED, O_CREAT | O_EXCL, PERMISSION, 1);
+    // MARK: Room
+
+    if (roomMode) {
+        struct hangmanRoomShm *page = roomMap(roomName, 1);
+
+        if (page == NULL) {
+            bail_out("Could not create room (ROOM_NAME)");
+        }
 
-    if (server == SEM_FAILED) {
-        bail_out("sem_open (SEM_SERVER)");
+        if (roomInit(&room, page) == -1) {
+            roomUnmap(page);
+            bail_out("roomInit");
+        }
+
+        for (int i = 0; i < workers; i++) {
+            shards[i].game.room = &room;
+        }
     }
 
-    if (client == SEM_FAILED) {
-        bail_out("sem_open (SEM_CLIENT)");
+    // MARK: Log
+
+    if (logStart(verbosity, stdout) == -1) {
+        bail_out("logStart");
     }
 
-    if (locked == SEM_FAILED) {
-        bail_out("sem_open (SEM_LOCKED)");
+    // MARK: Trace
+
+    if (tracePath != NULL && traceStart(tracePath) == -1) {
+        bail_out("Could not create trace file");
     }
 
-    // MARK: Server-Client
+    // MARK: Workers
 
-    while (1) {
-        (void)printf("\n\nClients: %i\nWaiting for a client...", calcClients());
-        (void)fflush(stdout);
+    sigset_t mask, old;
 
-        if (sem_wait(client) < 0) {
-            bail_out("sem_wait(client)");
-        }
+    // Signals are handled by the dispatcher only
+    (void)sigemptyset(&mask);
+    (void)sigaddset(&mask, SIGINT);
+    (void)sigaddset(&mask, SIGTERM);
+    (void)sigaddset(&mask, SIGHUP);
+    (void)pthread_sigmask(SIG_BLOCK, &mask, &old);
 
-        (void)printf("Client");
+    if (dictsStart(&dicts) == -1) {
+        bail_out("dictsStart");
+    }
 
-        int id = shared->id;
+    if (players.header != NULL && playersStart(&players) == -1) {
+        bail_out("playersStart");
+    }
 
-        if (shared->signal == 0) {
-            struct hangmanData *clientData = getClient(id);
+    if (workers > 1) {
+        for (int i = 0; i < workers; i++) {
+            eventInit(&shards[i].wake);
 
-            if (clientData == NULL) {
-                clientData = addClient(id);
+            if (pthread_create(&shards[i].thread, NULL, transport == TRANSPORT_SOCKET ? pollSockets : work, &shards[i]) != 0) {
+                bail_out("pthread_create");
             }
+        }
+    }
 
-            (void)printf("(%i) [%i - %c]\n", id, clientData->status, shared->send);
+    (void)pthread_sigmask(SIG_SETMASK, &old, NULL);
 
-            if (clientData->status > 1) {
-                // In game
+    // MARK: Server-Client
 
-                int index = clientData->index;
+    unsigned int spin = 0; // Spin history of the doorbell
+    uint64_t nextReap = 0;
 
-                if (shared->send < 'A' || shared->send > 'Z') {
-                    clientData->status = 3;
-                    (void)strcpy(clientData->info, "Invalid input.");
-                } else if (strchr(clientData->guessed, shared->send) == NULL) {
-                    int no = (int)shared->send - 65;
-                    clientData->guessed[no] = shared->send;
+    if (transport == TRANSPORT_SOCKET) {
+        if (workers == 1) {
+            (void)pollSockets(&shards[0]);
+        }
 
-                    if (strchr(words[index], shared->send)) {
-                        clearWord(id, index);
-                    } else {
-                        clientData->wrongGuesses++;
-                    }
+        while (1) {
+            (void)pause(); // Workers serve the sockets, the main thread only handles signals
+        }
+    }
 
-                    (void)strcpy(clientData->info, failureDrawing[clientData->wrongGuesses]);
-                    clientData->status = 2;
-
-                    if (clientData->wrongGuesses == 9) {
-                        clientData->status = 0;
-                        clientData->clientL++;
-                        (void)strcpy(clientData->word, words[index]);
-                    } else {
-                        if (!strchr(clientData->word, '_')) {
-                            clientData->status = 0;
-                            clientData->clientW++;
-                        }
-                    }
-                } else {
-                    clientData->status = 3;
-                    (void)strcpy(clientData->info, "Already guessed.");
-                }
-            } else if (clientData->status >= 0) {
-                // Not in game
-
-                if (shared->send == 'Y') {
-                    clientData->status = 2;
-                    clientData->index++;
-
-                    if (clientData->index < wordCount) {
-                        memset(&clientData->word, 0, MAX_WORD_LENGTH);
-                        memset(&clientData->word, '_', strlen(words[clientData->index]));
-                        clientData->wrongGuesses = 0;
-                        (void)strcpy(clientData->info, failureDrawing[clientData->wrongGuesses]);
-                        memset(&clientData->guessed, '_', 26);
-                    } else {
-                        clientData->status = -1;
-                        strcpy(clientData->info, "No more words");
-                    }
-                } else if (shared->send == 'N') {
-                    // N or Invalid input
-                    clientData->status = -1;
-                    (void)strcpy(clientData->info, "Quit game");
-                } else {
-                    clientData->status = 1;
-                    (void)strcpy(clientData->info, "Invalid input");
-                }
+    while (1) {
+        if (logLevel >= LOG_DEBUG) {
+            int clients = 0;
+
+            for (int i = 0; i < workers; i++) {
+                clients += calcClients(&shards[i].game);
             }
-        } else {
-            (void)printf("(%i)\nClient disconnected, free resources", id);
-            getClient(id)->status = -1;
-            (void)strcpy(getClient(id)->info, "Client shutdown");
+
+            logWrite(LOG_DEBUG, LOG_WAITING, 0, 0, '\0', clients);
         }
 
-        struct hangmanData *clientData = getClient(id);
+        int result;
+
+        if (waitMode == WAIT_FUTEX) {
+            struct timespec timeout = { REAP_INTERVAL / 1000000000u, REAP_INTERVAL % 1000000000u };
 
-        shared->status = clientData->status;
-        shared->wrongGuesses = clientData->wrongGuesses;
-        shared->index = clientData->index;
-        shared->clientW = clientData->clientW;
-        shared->clientL = clientData->clientL;
-        (void)strcpy(shared->guessed, clientData->guessed);
-        (void)strcpy(shared->word, clientData->word);
-        (void)strcpy(shared->info, clientData->info);
+            result = eventWait(&shm->doorbell, &spin, spinLimit, &timeout);
+        } else {
+            struct timespec deadline;
 
-        if (sem_post(server) < 0) {
-            bail_out("sem_post(server)");
+            (void)clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += REAP_INTERVAL / 1000000000u;
+            result = semWaitUntil(client, &deadline);
         }
 
-        if (clientData->status == -1) {         // Client should be removed
-            removeClient(id);
+        if (result < 0 && errno != EINTR && errno != ETIMEDOUT) {
+            bail_out("sem_wait(client)");
+        }
+
+        drain();
+
+        // Also while busy, a dead client still blocks admission to its slot
+        if (metricsNow() >= nextReap) {
+            reap();
+            tick();
+            publishLoad();
+            nextReap = metricsNow() + REAP_INTERVAL;
         }
     }
 }
@@ -381,87 +988,168 @@ static void bail_out(char *error) {
 }
 
 static void usage(void) {
-    (void)fprintf(stderr, "Usage: %s [input-file]\n", progname);
+    (void)fprintf(stderr, "Usage: %s [-a fifo|sem] [-j workers] [-m max-sessions] [-n instance] [-o order|random|length] [-P player-file[:seconds]] [-R] [-s] [-T trace-file] [-t seconds] [-u] [-v verbosity(0-2)] [-w sem|futex[:spins]] [input-file]\n"
+                  "\t-a admit waiting clients in arrival order (default) or through a semaphore\n"
+                  "\t-n run as a named instance (default " INSTANCE_ENV "), its objects get .instance appended and clients find it in the registry\n"
+                  "\t-o hand out words in file order, at random (default) or with every word length equally likely\n"
+                  "\t-P keep the scores of named players in player-file, snapshot every seconds (default 60) and on exit\n"
+                  "\t-R room mode, all clients guess the same word and spectators (hangman-client -S) watch it\n"
+                  "\t-s answer hint requests ('?' during a game) with the best letter for the words still matching\n"
+                  "\t-T record every request to trace-file for hangman-replay\n"
+                  "\t-t expire sessions idle for seconds (default 1800), 0 keeps them until the client quits or dies\n"
+                  "\t-u serve a Unix socket (" SOCKET_PATH "[.instance]) instead of shared memory, Linux only\n"
+                  "\t-w wake up with semaphores (default, Linux only) or futexes, waiters spin up to spins iterations (default 1000) first\n", progname);
     exit(EXIT_FAILURE);
 }
 
-/**
- * Recursive free on hangmanlost
- * @param next Item to free
- */
-static void free_hangman(struct hangmanList *next) {
-    if (next == NULL) {
-        return;
-    } else {
-        free_hangman(next->next);
-        free(next);
+static void free_alloc(void) {
+    // New clients go to the other instances while this one shuts down
+    registryLeave(&registry);
+
+    logStop();
+
+    if (traceActive) {
+        uint64_t records;
+
+        if (traceStop(&records) == -1) {
+            (void)fprintf(stderr, "%s: Could not write trace\n", progname);
+        } else {
+            (void)printf("Traced %llu requests to %s\n", (unsigned long long)records, tracePath);
+        }
     }
-}
 
-static void free_alloc(void) {
-    free_hangman(hangmanListHead);
+    // Worker threads may still be running, their memory is released with the process
+    if (workers == 1) {
+        if (shards != NULL) {
+            gameFree(&shards[0].game);
+            free(shards);
+            shards = NULL;
+        }
+
+        if (room.shm != NULL) {
+            roomFree(&room, &dicts);
+        }
 
-    for (size_t i = 0; i < wordCount; i++) {
-        free(words[i]);
+        dictsFree(&dicts);
     }
 
-    free(words);
+    // The snapshot thread may still run, the mapping is released with the process
+    if (players.header != NULL) {
+        if (playersSnapshot(&players) == -1) {
+            (void)fprintf(stderr, "%s: Could not save players\n", progname);
+        } else {
+            (void)printf("Saved %llu players to %s\n", (unsigned long long)players.header->count, players.path);
+        }
+    }
 
     if (client != NULL) {
         (void)sem_close(client);
     }
 
-    if (server != NULL) {
-        (void)sem_close(server);
-    }
-
     if (locked != NULL) {
         (void)sem_close(locked);
     }
 
-    (void)sem_unlink(SEM_SERVER);
-    (void)sem_unlink(SEM_CLIENT);
-    (void)sem_unlink(SEM_LOCKED);
+    // Another server of the same name owns them
+    if (owner && transport == TRANSPORT_SHM) {
+        (void)sem_unlink(semClient);
+        (void)sem_unlink(semLocked);
+    }
 
-	(void)munmap(shared, sizeof(shared));
+    if (shm != NULL && workers == 1) {
+#ifdef __linux__
+        for (size_t i = 0; i < MAX_SLOTS && waitMode == WAIT_SEM; i++) {
+            (void)sem_destroy(&shm->slots[i].reply);
+        }
+#endif
 
-	if (shm_unlink(SHM_NAME) == -1) {
+        (void)munmap(shm, sizeof(struct hangmanShm));
+    }
+
+	if (owner && transport == TRANSPORT_SHM && shm_unlink(shmName) == -1) {
 		(void)fprintf(stderr, "%s: shm_unlink\n", progname);
 	}
-}
 
-static void readFile(FILE *file) {
-    char c;
-    char line[MAX_WORD_LENGTH];
+    if (listener != -1) {
+        (void)close(listener);
+        (void)unlink(socketPath);
+        listener = -1;
+    }
+
+    if (metrics != NULL) {
+        (void)shm_unlink(metricsName);
+
+        if (workers == 1) {
+            (void)munmap(metrics, metricsSize(metrics->workers));
+            metrics = NULL;
+        }
+    }
 
-    c = fgetc(file);
-    int i = 0;
+    // Spectators notice that the server is gone by its start time
+    if (room.shm != NULL) {
+        (void)shm_unlink(roomName);
 
-    while (c != EOF) {
-        if (i < MAX_WORD_LENGTH && ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
-            line[i++] = c;
-        } else if (c == '\n' || c == ' ') {
-            line[i] = '\0';
-            addWord(line);
-            i = 0;
+        if (workers == 1) {
+            roomUnmap(room.shm);
+            room.shm = NULL;
         }
+    }
 
-        c = fgetc(file);
+    if (workers == 1) {
+        registryClose(&registry);
     }
+}
+
+static void readFile(FILE *file, const char *path) {
+    struct hangmanWords *words = &dicts.current->words;
+    struct timespec start, end;
+    struct rusage usage;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (path != NULL && wordsIsCompiled(file)) {
+        if (wordsMap(words, path) == -1) {
+            bail_out("Invalid dictionary");
+        }
 
-    for (size_t i = 0; i < wordCount; i++) {
-        (void)printf("%s\n", words[i]);
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    } else {
+        if (wordsRead(words, file) == -1) {
+            bail_out("Could not read words");
+        }
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+        for (size_t i = 0; i < words->count; i++) {
+            (void)printf("%s\n", wordAt(words, i));
+        }
     }
+
+    (void)getrusage(RUSAGE_SELF, &usage);
+    (void)printf("Loaded %zu words in %.1f ms (store: %zu KiB, resident: %ld KiB)\n", words->count,
+                 (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6,
+                 wordsMemory(words) / 1024, usage.ru_maxrss);
+}
+
+static void reloadHandler(int sig) {
+    (void)sig;
+    dictsReload(&dicts);
 }
 
 static void signalHandler(int sig) {
     (void)printf("\nEXIT (%i)\n", sig);
 
-    (void)strcpy(shared->info, "Server shutdown");
-    shared->signal = -2;
+    if (shm != NULL) {
+        shm->status = -2;
+
+        for (size_t i = 0; i < MAX_SLOTS; i++) {
+            (void)strcpy(shm->slots[i].data.info, hangmanMessages[MESSAGE_SERVER_SHUTDOWN]);
+            shm->slots[i].compact.message = MESSAGE_SERVER_SHUTDOWN;
+        }
+    }
 
-    for (struct hangmanList *head = hangmanListHead; head != NULL; head = head->next) {
-        (void)kill(head->data.id, SIGTERM);
+    for (int i = 0; shards != NULL && i < workers; i++) {
+        gameSignal(&shards[i].game, SIGTERM);
     }
 
     free_alloc();
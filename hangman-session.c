@@ -0,0 +1,188 @@
+/**
+ * @file hangman-session.c
+ * @brief Session table of hangman-server, linear probing with backward shift deletion,
+ *        and the freelist pool of session records
+ */
+#include <stdlib.h>
+
+#include "hangman-session.h"
+
+/**
+ * Bucket a client id hashes to (Fibonacci hashing)
+ * @param  sessions Session table
+ * @param  id       ID of the client
+ * @return          Index of the home bucket
+ */
+static size_t home(const struct hangmanSessions *sessions, int id) {
+    return (size_t)(((unsigned int)id * 2654435769u) & (sessions->capacity - 1));
+}
+
+/**
+ * Inserts into a table that is known to have room
+ * @param sessions Session table
+ * @param data     Session to insert
+ */
+static void place(struct hangmanSessions *sessions, struct hangmanData *data) {
+    size_t mask = sessions->capacity - 1;
+    size_t i = home(sessions, data->id);
+
+    while (sessions->entries[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+
+    sessions->entries[i] = data;
+}
+
+/**
+ * Doubles the number of buckets
+ * @param  sessions Session table
+ * @return          0 on success, -1 if out of memory
+ */
+static int grow(struct hangmanSessions *sessions) {
+    struct hangmanData **old = sessions->entries;
+    size_t oldCapacity = sessions->capacity;
+
+    sessions->entries = (struct hangmanData **)calloc(oldCapacity * 2, sizeof(struct hangmanData *));
+
+    if (sessions->entries == NULL) {
+        sessions->entries = old;
+        return -1;
+    }
+
+    sessions->capacity = oldCapacity * 2;
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i] != NULL) {
+            place(sessions, old[i]);
+        }
+    }
+
+    free(old);
+    return 0;
+}
+
+int sessionInit(struct hangmanSessions *sessions, size_t capacity) {
+    size_t size = 8;
+
+    while (size < capacity) {
+        size *= 2;
+    }
+
+    sessions->entries = (struct hangmanData **)calloc(size, sizeof(struct hangmanData *));
+    sessions->capacity = sessions->entries != NULL ? size : 0;
+    sessions->count = 0;
+
+    return sessions->entries != NULL ? 0 : -1;
+}
+
+struct hangmanData *sessionGet(const struct hangmanSessions *sessions, int id) {
+    if (sessions->capacity == 0) {
+        return NULL;
+    }
+
+    size_t mask = sessions->capacity - 1;
+
+    for (size_t i = home(sessions, id); sessions->entries[i] != NULL; i = (i + 1) & mask) {
+        if (sessions->entries[i]->id == id) {
+            return sessions->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+int sessionPut(struct hangmanSessions *sessions, struct hangmanData *data) {
+    if ((sessions->count + 1) * 4 > sessions->capacity * 3 && grow(sessions) == -1) {       // Keep the load factor below 3/4
+        return -1;
+    }
+
+    place(sessions, data);
+    sessions->count++;
+
+    return 0;
+}
+
+struct hangmanData *sessionRemove(struct hangmanSessions *sessions, int id) {
+    if (sessions->capacity == 0) {
+        return NULL;
+    }
+
+    size_t mask = sessions->capacity - 1;
+    size_t i = home(sessions, id);
+
+    while (sessions->entries[i] != NULL && sessions->entries[i]->id != id) {
+        i = (i + 1) & mask;
+    }
+
+    struct hangmanData *removed = sessions->entries[i];
+
+    if (removed == NULL) {
+        return NULL;
+    }
+
+    // Shift following entries back so no probe sequence is broken
+    size_t hole = i;
+
+    for (size_t j = (i + 1) & mask; sessions->entries[j] != NULL; j = (j + 1) & mask) {
+        size_t want = home(sessions, sessions->entries[j]->id);
+
+        if (((j - want) & mask) >= ((j - hole) & mask)) {
+            sessions->entries[hole] = sessions->entries[j];
+            hole = j;
+        }
+    }
+
+    sessions->entries[hole] = NULL;
+    sessions->count--;
+
+    return removed;
+}
+
+void sessionFree(struct hangmanSessions *sessions) {
+    free(sessions->entries);
+    sessions->entries = NULL;
+    sessions->capacity = 0;
+    sessions->count = 0;
+}
+
+int poolInit(struct hangmanPool *pool, size_t capacity) {
+    pool->records = (struct hangmanData *)malloc(capacity * sizeof(struct hangmanData));
+    pool->free = (struct hangmanData **)malloc(capacity * sizeof(struct hangmanData *));
+    pool->capacity = capacity;
+    pool->available = capacity;
+
+    if (pool->records == NULL || pool->free == NULL) {
+        poolFree(pool);
+        return -1;
+    }
+
+    // Hand out the records in address order
+    for (size_t i = 0; i < capacity; i++) {
+        pool->free[i] = &pool->records[capacity - 1 - i];
+    }
+
+    return 0;
+}
+
+struct hangmanData *poolAlloc(struct hangmanPool *pool) {
+    if (pool->available == 0) {
+        return NULL;
+    }
+
+    return pool->free[--pool->available];
+}
+
+void poolRelease(struct hangmanPool *pool, struct hangmanData *data) {
+    if (data != NULL) {
+        pool->free[pool->available++] = data;
+    }
+}
+
+void poolFree(struct hangmanPool *pool) {
+    free(pool->records);
+    free(pool->free);
+    pool->records = NULL;
+    pool->free = NULL;
+    pool->capacity = 0;
+    pool->available = 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file hangman-session.h
+ * @brief Session table of hangman-server, an open-addressing hash table keyed by client id,
+ *        and the pool the session records are allocated from
+ */
+#ifndef HANGMAN_SESSION_H
+#define HANGMAN_SESSION_H
+
+#include <stddef.h>
+
+#include "hangman-proto.h"
+
+struct hangmanSessions {
+    struct hangmanData **entries; // NULL marks an empty bucket
+    size_t capacity; // Power of two
+    size_t count; // Number of connected clients
+};
+
+struct hangmanPool {
+    struct hangmanData *records; // One preallocated block holding every record
+    struct hangmanData **free; // Stack of unused records
+    size_t capacity;
+    size_t available;
+};
+
+/**
+ * Preallocates a pool of session records
+ * @param  pool     Pool to initialize
+ * @param  capacity Maximum number of sessions
+ * @return          0 on success, -1 if out of memory
+ */
+int poolInit(struct hangmanPool *pool, size_t capacity);
+
+/**
+ * Takes a record from the pool in O(1)
+ * @param  pool Session pool
+ * @return      Uninitialized record or NULL if all records are in use
+ */
+struct hangmanData *poolAlloc(struct hangmanPool *pool);
+
+/**
+ * Returns a record to the pool in O(1)
+ * @param pool Session pool
+ * @param data Record obtained from poolAlloc, may be NULL
+ */
+void poolRelease(struct hangmanPool *pool, struct hangmanData *data);
+
+/**
+ * Frees all records at once
+ * @param pool Session pool
+ */
+void poolFree(struct hangmanPool *pool);
+
+/**
+ * Prepares an empty session table
+ * @param  sessions Table to initialize
+ * @param  capacity Initial number of buckets, rounded up to a power of two
+ * @return          0 on success, -1 if out of memory
+ */
+int sessionInit(struct hangmanSessions *sessions, size_t capacity);
+
+/**
+ * Looks up a session
+ * @param  sessions Session table
+ * @param  id       ID of the client
+ * @return          Session of the client or NULL if there is none
+ */
+struct hangmanData *sessionGet(const struct hangmanSessions *sessions, int id);
+
+/**
+ * Inserts a session keyed by data->id, the table grows if needed
+ * @param  sessions Session table
+ * @param  data     Session to insert, must not be in the table yet
+ * @return          0 on success, -1 if out of memory
+ */
+int sessionPut(struct hangmanSessions *sessions, struct hangmanData *data);
+
+/**
+ * Removes a session from the table
+ * @param  sessions Session table
+ * @param  id       ID of the client
+ * @return          The removed session or NULL if there was none
+ */
+struct hangmanData *sessionRemove(struct hangmanSessions *sessions, int id);
+
+/**
+ * Frees the buckets of the table, not the sessions themselves
+ * @param sessions Session table
+ */
+void sessionFree(struct hangmanSessions *sessions);
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file hangman-solve.c
+ * @brief Ranks the letters to guess next for a pattern against a word list or compiled dictionary
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "hangman-solver.h"
+
+#define RANKED 5 // Letters printed
+
+char *progname;
+
+struct hangmanWords words;
+struct hangmanSolver solver;
+
+/**
+ * Exits the programm and writes a usage description to stderr
+ */
+static void usage(void) {
+    (void)fprintf(stderr, "Usage: %s [-i scalar|sse|avx2] [-n rounds] dictionary pattern [guessed]\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Exits the programm freeing allocated space and printing an error message to stderr
+ * @param error Error description
+ */
+static void bail_out(char *error) {
+    (void)fprintf(stderr, "%s: %s\n", progname, error);
+    solverFree(&solver);
+    wordsFree(&words);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static double now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Main
+ * @brief     Main Function
+ * @param     argc Number of arguments
+ * @param     argv Array of arguments of type char*
+ * @result    int EXIT_SUCCESS or in case of an error EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    static const char *isas[] = { "scalar", "sse", "avx2" };
+
+    progname = argv[0];
+    int isa = -1;
+    long rounds = 1;
+    char *end;
+    int c;
+
+    while ((c = getopt(argc, argv, "i:n:")) != -1) {
+        switch (c) {
+            case 'i':
+                for (isa = SOLVER_AVX2; isa >= 0 && strcmp(optarg, isas[isa]) != 0; isa--) {
+                }
+
+                if (isa == -1) {
+                    usage();
+                }
+                break;
+
+            case 'n':
+                rounds = strtol(optarg, &end, 10);
+
+                if (*end != '\0' || rounds < 1) {
+                    usage();
+                }
+                break;
+
+            case '?':
+                usage();
+                break;
+
+            default:
+                assert(0);
+        }
+    }
+
+    if (argc - optind < 2 || argc - optind > 3) {
+        usage();
+    }
+
+    char pattern[MAX_WORD_LENGTH];
+    uint32_t guessed = 0;
+    size_t length = strlen(argv[optind + 1]);
+
+    if (length == 0 || length >= MAX_WORD_LENGTH) {
+        usage();
+    }
+
+    for (size_t p = 0; p <= length; p++) {
+        char letter = (char)toupper((unsigned char)argv[optind + 1][p]);
+
+        if (letter != '\0' && letter != '_' && (letter < 'A' || letter > 'Z')) {
+            usage();
+        }
+
+        pattern[p] = letter;
+
+        if (letter >= 'A' && letter <= 'Z') {
+            guessed |= 1u << (letter - 'A');
+        }
+    }
+
+    for (const char *letter = argc - optind == 3 ? argv[optind + 2] : ""; *letter != '\0'; letter++) {
+        if (!isalpha((unsigned char)*letter)) {
+            usage();
+        }
+
+        guessed |= 1u << (toupper((unsigned char)*letter) - 'A');
+    }
+
+    // MARK: Dictionary
+
+    wordsInit(&words);
+
+    FILE *file = fopen(argv[optind], "r");
+
+    if (file == NULL) {
+        bail_out("Could not read file");
+    }
+
+    if (wordsIsCompiled(file) ? wordsMap(&words, argv[optind]) == -1 : wordsRead(&words, file) == -1) {
+        (void)fclose(file);
+        bail_out("Could not read words");
+    }
+
+    (void)fclose(file);
+
+    double start = now();
+
+    if (solverBuild(&solver, &words) == -1) {
+        bail_out("solverBuild");
+    }
+
+    double built = now() - start;
+
+    if (isa > solver.isa) {
+        bail_out("Instruction set not supported");
+    } else if (isa != -1) {
+        solver.isa = isa;
+    }
+
+    // MARK: Rank
+
+    char letters[RANKED];
+    uint32_t candidates = 0;
+    int ranked = 0;
+
+    start = now();
+
+    for (long i = 0; i < rounds; i++) {
+        ranked = solverRank(&solver, pattern, guessed, letters, RANKED, &candidates);
+    }
+
+    double elapsed = (now() - start) / rounds;
+    uint32_t scanned = solver.group[length].count;
+
+    (void)printf("%u candidates of %u words with %zu letters\n", candidates, scanned, length);
+
+    for (int i = 0; i < ranked; i++) {
+        (void)printf("%s%c", i > 0 ? " " : "", letters[i]);
+    }
+
+    (void)printf("%s", ranked > 0 ? "\n" : "");
+    (void)printf("%s: %.1f ms build, %.1f us per rank, %.0f M words/s\n", isas[solver.isa], built / 1e6,
+                 elapsed / 1e3, elapsed > 0 ? scanned / elapsed * 1e3 : 0);
+
+    solverFree(&solver);
+    wordsFree(&words);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,358 @@
+/**
+ * @file hangman-solver.c
+ * @brief Solver of hangman-solve, hangman-bench and the hints of hangman-server
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "hangman-solver.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SOLVER_X86
+#endif
+
+/**
+ * Candidates of the last block of a group, padding never matches
+ * @param  group Group
+ * @param  block First word of the block
+ * @return       Bit n is set if word block + n exists
+ */
+static uint32_t validBits(const struct hangmanSolverGroup *group, uint32_t block) {
+    if (block >= group->count) {
+        return 0;
+    }
+
+    uint32_t left = group->count - block;
+
+    return left >= SOLVER_BLOCK ? UINT32_MAX : (1u << left) - 1;
+}
+
+int solverBuild(struct hangmanSolver *solver, const struct hangmanWords *words) {
+    uint32_t filled[MAX_WORD_LENGTH] = { 0 };
+
+    memset(solver, 0, sizeof(*solver));
+    solver->isa = solverIsa();
+
+    // Damaged words of a mapped dictionary are left out
+    for (size_t i = 0; i < words->count; i++) {
+        if (wordValid(words, i)) {
+            solver->group[words->length[i]].count++;
+        }
+    }
+
+    for (size_t length = 1; length < MAX_WORD_LENGTH; length++) {
+        struct hangmanSolverGroup *group = &solver->group[length];
+
+        if (group->count == 0) {
+            continue;
+        }
+
+        group->padded = (group->count + SOLVER_BLOCK - 1) / SOLVER_BLOCK * SOLVER_BLOCK;
+        group->letters = (char *)calloc((size_t)group->padded * length, 1);
+        group->mask = (uint32_t *)calloc(group->padded, sizeof(uint32_t));
+
+        if (group->letters == NULL || group->mask == NULL) {
+            solverFree(solver);
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < words->count; i++) {
+        if (!wordValid(words, i)) {
+            continue;
+        }
+
+        struct hangmanSolverGroup *group = &solver->group[words->length[i]];
+        const char *word = wordAt(words, i);
+        uint32_t n = filled[words->length[i]]++;
+
+        for (size_t p = 0; p < words->length[i]; p++) {
+            group->letters[p * group->padded + n] = word[p];
+        }
+
+        group->mask[n] = words->mask[i];
+    }
+
+    return 0;
+}
+
+void solverFree(struct hangmanSolver *solver) {
+    for (size_t length = 0; length < MAX_WORD_LENGTH; length++) {
+        free(solver->group[length].letters);
+        free(solver->group[length].mask);
+        solver->group[length].letters = NULL;
+        solver->group[length].mask = NULL;
+        solver->group[length].count = 0;
+        solver->group[length].padded = 0;
+    }
+}
+
+int solverIsa(void) {
+#ifdef SOLVER_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return SOLVER_AVX2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return SOLVER_SSE;
+    }
+#endif
+
+    return SOLVER_SCALAR;
+}
+
+/**
+ * Matches a pattern word by word
+ * @param  group    Words of the length of the pattern
+ * @param  pattern  Uppercase word with '_' for hidden letters
+ * @param  correct  Letters of the pattern, hidden positions can not hold them
+ * @param  corrects Number of letters in correct
+ * @param  wrong    Guessed letters the words can not contain
+ * @param  counts   Incremented for every letter of every candidate
+ * @return          Number of candidates
+ */
+static uint32_t countScalar(const struct hangmanSolverGroup *group, const char *pattern, size_t length,
+                            const char *correct, int corrects, uint32_t wrong, uint32_t counts[26]) {
+    uint32_t revealed = 0;
+    uint32_t found = 0;
+
+    for (int k = 0; k < corrects; k++) {
+        revealed |= 1u << (correct[k] - 'A');
+    }
+
+    for (uint32_t i = 0; i < group->count; i++) {
+        int match = (group->mask[i] & wrong) == 0;
+
+        for (size_t p = 0; p < length && match; p++) {
+            char letter = group->letters[p * group->padded + i];
+
+            match = pattern[p] != '_' ? letter == pattern[p] : (revealed & (1u << (letter - 'A'))) == 0;
+        }
+
+        if (match) {
+            found++;
+
+            for (uint32_t mask = group->mask[i]; mask != 0; mask &= mask - 1) {
+                counts[__builtin_ctz(mask)]++;
+            }
+        }
+    }
+
+    return found;
+}
+
+#ifdef SOLVER_X86
+
+/**
+ * Matches a pattern against 16 words at once, see countScalar
+ */
+__attribute__((target("sse2")))
+static uint32_t countSse(const struct hangmanSolverGroup *group, const char *pattern, size_t length,
+                         const char *correct, int corrects, uint32_t wrong, uint32_t counts[26]) {
+    const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i wrongs = _mm_set1_epi32((int)wrong);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i totals[26];
+    uint32_t found = 0;
+
+    for (int letter = 0; letter < 26; letter++) {
+        totals[letter] = zero;
+    }
+
+    for (uint32_t block = 0; block < group->padded; block += 16) {
+        __m128i match = _mm_set1_epi8(-1);
+
+        for (size_t p = 0; p < length && _mm_movemask_epi8(match) != 0; p++) {
+            __m128i column = _mm_loadu_si128((const __m128i *)(group->letters + p * group->padded + block));
+
+            if (pattern[p] != '_') {
+                match = _mm_and_si128(match, _mm_cmpeq_epi8(column, _mm_set1_epi8(pattern[p])));
+            } else {
+                for (int k = 0; k < corrects; k++) {
+                    match = _mm_andnot_si128(_mm_cmpeq_epi8(column, _mm_set1_epi8(correct[k])), match);
+                }
+            }
+        }
+
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(match) & validBits(group, block);
+
+        for (int chunk = 0; chunk < 4 && bits != 0; chunk++, bits >>= 4) {
+            if ((bits & 0xf) == 0) {
+                continue;
+            }
+
+            __m128i masks = _mm_loadu_si128((const __m128i *)(group->mask + block + 4 * chunk));
+            __m128i selected = _mm_and_si128(_mm_set1_epi32((int)(bits & 0xf)), lanes);
+            __m128i keep = _mm_and_si128(_mm_cmpeq_epi32(selected, lanes), _mm_cmpeq_epi32(_mm_and_si128(masks, wrongs), zero));
+            __m128i rest = _mm_and_si128(masks, keep);
+
+            found += (uint32_t)__builtin_popcount((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(keep)));
+
+            // Letter by letter, the lowest bit of every lane
+            for (int letter = 0; letter < 26; letter++) {
+                totals[letter] = _mm_add_epi32(totals[letter], _mm_and_si128(rest, one));
+                rest = _mm_srli_epi32(rest, 1);
+            }
+        }
+    }
+
+    for (int letter = 0; letter < 26; letter++) {
+        uint32_t lane[4];
+
+        _mm_storeu_si128((__m128i *)lane, totals[letter]);
+        counts[letter] += lane[0] + lane[1] + lane[2] + lane[3];
+    }
+
+    return found;
+}
+
+/**
+ * Matches a pattern against 32 words at once, see countScalar
+ */
+__attribute__((target("avx2")))
+static uint32_t countAvx2(const struct hangmanSolverGroup *group, const char *pattern, size_t length,
+                          const char *correct, int corrects, uint32_t wrong, uint32_t counts[26]) {
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i wrongs = _mm256_set1_epi32((int)wrong);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i totals[26];
+    uint32_t found = 0;
+
+    for (int letter = 0; letter < 26; letter++) {
+        totals[letter] = zero;
+    }
+
+    for (uint32_t block = 0; block < group->padded; block += SOLVER_BLOCK) {
+        __m256i match = _mm256_set1_epi8(-1);
+
+        for (size_t p = 0; p < length && !_mm256_testz_si256(match, match); p++) {
+            __m256i column = _mm256_loadu_si256((const __m256i *)(group->letters + p * group->padded + block));
+
+            if (pattern[p] != '_') {
+                match = _mm256_and_si256(match, _mm256_cmpeq_epi8(column, _mm256_set1_epi8(pattern[p])));
+            } else {
+                for (int k = 0; k < corrects; k++) {
+                    match = _mm256_andnot_si256(_mm256_cmpeq_epi8(column, _mm256_set1_epi8(correct[k])), match);
+                }
+            }
+        }
+
+        uint32_t bits = (uint32_t)_mm256_movemask_epi8(match) & validBits(group, block);
+
+        for (int chunk = 0; chunk < 4 && bits != 0; chunk++, bits >>= 8) {
+            if ((bits & 0xff) == 0) {
+                continue;
+            }
+
+            __m256i masks = _mm256_loadu_si256((const __m256i *)(group->mask + block + 8 * chunk));
+            __m256i selected = _mm256_and_si256(_mm256_set1_epi32((int)(bits & 0xff)), lanes);
+            __m256i keep = _mm256_and_si256(_mm256_cmpeq_epi32(selected, lanes), _mm256_cmpeq_epi32(_mm256_and_si256(masks, wrongs), zero));
+            __m256i rest = _mm256_and_si256(masks, keep);
+
+            found += (uint32_t)__builtin_popcount((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(keep)));
+
+            // Letter by letter, the lowest bit of every lane
+            for (int letter = 0; letter < 26; letter++) {
+                totals[letter] = _mm256_add_epi32(totals[letter], _mm256_and_si256(rest, one));
+                rest = _mm256_srli_epi32(rest, 1);
+            }
+        }
+    }
+
+    for (int letter = 0; letter < 26; letter++) {
+        uint32_t lane[8];
+
+        _mm256_storeu_si256((__m256i *)lane, totals[letter]);
+        counts[letter] += lane[0] + lane[1] + lane[2] + lane[3] + lane[4] + lane[5] + lane[6] + lane[7];
+    }
+
+    return found;
+}
+
+#endif
+
+uint32_t solverCount(const struct hangmanSolver *solver, const char *pattern, uint32_t guessed, uint32_t counts[26]) {
+    size_t length = strlen(pattern);
+    char correct[26];
+    int corrects = 0;
+    uint32_t revealed = 0;
+
+    memset(counts, 0, 26 * sizeof(uint32_t));
+
+    if (length == 0 || length >= MAX_WORD_LENGTH) {
+        return 0;
+    }
+
+    for (size_t p = 0; p < length; p++) {
+        if (pattern[p] >= 'A' && pattern[p] <= 'Z' && (revealed & (1u << (pattern[p] - 'A'))) == 0) {
+            revealed |= 1u << (pattern[p] - 'A');
+            correct[corrects++] = pattern[p];
+        }
+    }
+
+    const struct hangmanSolverGroup *group = &solver->group[length];
+    uint32_t wrong = guessed & ~revealed & 0x3ffffff;
+
+#ifdef SOLVER_X86
+    if (solver->isa == SOLVER_AVX2) {
+        return countAvx2(group, pattern, length, correct, corrects, wrong, counts);
+    }
+
+    if (solver->isa == SOLVER_SSE) {
+        return countSse(group, pattern, length, correct, corrects, wrong, counts);
+    }
+#endif
+
+    return countScalar(group, pattern, length, correct, corrects, wrong, counts);
+}
+
+int solverRank(const struct hangmanSolver *solver, const char *pattern, uint32_t guessed, char *letters, int max, uint32_t *candidates) {
+    uint32_t counts[26];
+    uint32_t found = solverCount(solver, pattern, guessed, counts);
+    int ranked = 0;
+
+    if (candidates != NULL) {
+        *candidates = found;
+    }
+
+    if (found == 0) {
+        return 0;
+    }
+
+    // Insertion sort, the answer to the letter of the most even split tells the most
+    for (int letter = 0; letter < 26; letter++) {
+        if (guessed & (1u << letter)) {
+            continue;
+        }
+
+        uint32_t split = counts[letter] < found - counts[letter] ? counts[letter] : found - counts[letter];
+        int at = ranked < max ? ranked : max;
+
+        while (at > 0) {
+            int previous = letters[at - 1] - 'A';
+            uint32_t other = counts[previous] < found - counts[previous] ? counts[previous] : found - counts[previous];
+
+            if (other > split || (other == split && counts[previous] >= counts[letter])) {
+                break;
+            }
+
+            if (at < max) {
+                letters[at] = letters[at - 1];
+            }
+
+            at--;
+        }
+
+        if (at < max) {
+            letters[at] = (char)('A' + letter);
+            ranked += ranked < max;
+        }
+    }
+
+    return ranked;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file hangman-solver.h
+ * @brief Solver of hangman-solve, hangman-bench and the hints of hangman-server. The words of
+ *        every length are stored column by column, a pattern is matched against 32 words at
+ *        once with AVX2, 16 with SSE2 or one by one, and the letters of the remaining
+ *        candidates are counted on the way
+ */
+#ifndef HANGMAN_SOLVER_H
+#define HANGMAN_SOLVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hangman-words.h"
+
+#define SOLVER_BLOCK 32 // Words per block, columns are padded to a multiple
+
+enum hangmanIsa {
+    SOLVER_SCALAR,
+    SOLVER_SSE, // SSE2
+    SOLVER_AVX2
+};
+
+/**
+ * Words of one length
+ */
+struct hangmanSolverGroup {
+    uint32_t count;
+    uint32_t padded; // count rounded up to SOLVER_BLOCK
+    char *letters; // Column p of the group starts at letters + p * padded
+    uint32_t *mask; // Letters of every word, see hangmanWords.mask
+};
+
+struct hangmanSolver {
+    struct hangmanSolverGroup group[MAX_WORD_LENGTH]; // By length
+    int isa; // Instruction set used, the best one available after solverBuild
+};
+
+/**
+ * Builds the columns of a word store
+ * @param  solver Solver to build
+ * @param  words  Word store
+ * @return        0 on success, -1 if out of memory
+ */
+int solverBuild(struct hangmanSolver *solver, const struct hangmanWords *words);
+
+/**
+ * Frees the columns, a zeroed solver is left alone
+ * @param solver Solver
+ */
+void solverFree(struct hangmanSolver *solver);
+
+/**
+ * Best instruction set of this CPU
+ * @return SOLVER_AVX2, SOLVER_SSE or SOLVER_SCALAR
+ */
+int solverIsa(void);
+
+/**
+ * Counts the words that match a pattern and the letters they contain
+ * @param  solver  Solver
+ * @param  pattern Uppercase word with '_' for hidden letters, '\0' terminated
+ * @param  guessed Bit n is set if letter 'A' + n was guessed
+ * @param  counts  Receives for every letter the number of candidates that contain it
+ * @return         Number of candidates
+ */
+uint32_t solverCount(const struct hangmanSolver *solver, const char *pattern, uint32_t guessed, uint32_t counts[26]);
+
+/**
+ * Ranks the letters that were not guessed yet by how much their answer tells, the letter that
+ * splits the candidates most evenly into hits and misses first, then the more likely hit
+ * @param  solver     Solver
+ * @param  pattern    Uppercase word with '_' for hidden letters
+ * @param  guessed    Bit n is set if letter 'A' + n was guessed
+ * @param  letters    Receives the best letters in order
+ * @param  max        Size of letters
+ * @param  candidates Receives the number of candidates, may be NULL
+ * @return            Number of letters written, 0 if no word matches
+ */
+int solverRank(const struct hangmanSolver *solver, const char *pattern, uint32_t guessed, char *letters, int max, uint32_t *candidates);
+
+#endif
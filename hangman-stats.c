@@ -0,0 +1,223 @@
+/**
+ * @file hangman-stats.c
+ * @brief Prints the live counters of a running hangman-server, read-only and without
+ *        taking part in the protocol
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <fcntl.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hangman-metrics.h"
+#include "hangman-registry.h"
+
+static const char *kindNames[METRIC_KINDS] = { "connect", "answer", "guess", "disconnect" };
+
+char *progname;
+
+/**
+ * Exits the programm and writes a usage description to stderr
+ */
+static void usage(void) {
+    (void)fprintf(stderr, "Usage: %s [-i interval-seconds] [-n instance] | -l\n"
+                  "\t-n read the counters of a named instance (default " INSTANCE_ENV ")\n"
+                  "\t-l list the running instances and their load\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Sums up the blocks of all shards
+ * @param metrics Metrics segment
+ * @param total   Destination
+ */
+static void collect(const struct hangmanMetrics *metrics, struct hangmanShardMetrics *total) {
+    memset(total, 0, sizeof(*total));
+
+    for (uint32_t i = 0; i < metrics->workers; i++) {
+        const struct hangmanShardMetrics *shard = &metrics->shard[i];
+
+        total->requests += metricRead(&shard->requests);
+        total->won += metricRead(&shard->won);
+        total->lost += metricRead(&shard->lost);
+        total->connects += metricRead(&shard->connects);
+        total->disconnects += metricRead(&shard->disconnects);
+        total->expired += metricRead(&shard->expired);
+        total->sessions += metricRead(&shard->sessions);
+
+        for (int kind = 0; kind < METRIC_KINDS; kind++) {
+            for (int j = 0; j < HIST_BUCKETS; j++) {
+                total->service[kind][j] += metricRead(&shard->service[kind][j]);
+            }
+        }
+    }
+}
+
+/**
+ * Prints one line of key=value pairs
+ * @param total    Current totals
+ * @param previous Totals of the previous line, NULL for the first line
+ * @param interval Seconds since the previous line
+ */
+static void print(const struct hangmanShardMetrics *total, const struct hangmanShardMetrics *previous, int interval) {
+    (void)printf("requests=%llu won=%llu lost=%llu sessions=%llu connects=%llu disconnects=%llu expired=%llu",
+                 (unsigned long long)total->requests, (unsigned long long)total->won, (unsigned long long)total->lost,
+                 (unsigned long long)total->sessions, (unsigned long long)total->connects, (unsigned long long)total->disconnects,
+                 (unsigned long long)total->expired);
+
+    if (previous != NULL) {
+        (void)printf(" requests_per_sec=%.1f", (double)(total->requests - previous->requests) / interval);
+    }
+
+    for (int kind = 0; kind < METRIC_KINDS; kind++) {
+        uint64_t window[HIST_BUCKETS];
+        uint64_t count = 0;
+
+        // Percentiles over the last interval when streaming, since startup otherwise
+        for (int j = 0; j < HIST_BUCKETS; j++) {
+            window[j] = total->service[kind][j] - (previous != NULL ? previous->service[kind][j] : 0);
+            count += window[j];
+        }
+
+        (void)printf(" %s_count=%llu %s_p50_ns=%llu %s_p99_ns=%llu %s_p999_ns=%llu", kindNames[kind], (unsigned long long)count,
+                     kindNames[kind], (unsigned long long)histPercentile(window, 0.5),
+                     kindNames[kind], (unsigned long long)histPercentile(window, 0.99),
+                     kindNames[kind], (unsigned long long)histPercentile(window, 0.999));
+    }
+
+    (void)printf("\n");
+    (void)fflush(stdout);
+}
+
+/**
+ * Prints the instances of the registry
+ * @return EXIT_SUCCESS, or EXIT_FAILURE if no registry exists
+ */
+static int list(void) {
+    struct hangmanRegistry registry;
+    struct hangmanInstance instances[REGISTRY_ENTRIES];
+
+    if (registryOpen(&registry, 0) == -1) {
+        (void)fprintf(stderr, "%s: No registry\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    int count = registryList(&registry, instances);
+
+    (void)printf("%-*s %8s %-9s %10s %10s %6s\n", INSTANCE_LENGTH - 1, "instance", "pid", "transport", "sessions", "capacity", "load");
+
+    for (int i = 0; i < count; i++) {
+        (void)printf("%-*s %8d %-9s %10u %10u %5.1f%%\n", INSTANCE_LENGTH - 1, instances[i].name[0] != '\0' ? instances[i].name : "-",
+                     instances[i].pid, instances[i].transport == TRANSPORT_SOCKET ? "socket" : "shm", instances[i].sessions,
+                     instances[i].capacity, instances[i].capacity > 0 ? 100.0 * instances[i].sessions / instances[i].capacity : 0);
+    }
+
+    registryClose(&registry);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Main
+ * @brief     Main Function
+ * @param     argc Number of arguments
+ * @param     argv Array of arguments of type char*
+ * @result    int EXIT_SUCCESS or in case of an error EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    progname = argv[0];
+    int interval = 0;
+    const char *instance = NULL;
+    int listing = 0;
+    char name[NAME_LENGTH];
+    char *end;
+    int c;
+
+    while ((c = getopt(argc, argv, "i:ln:")) != -1) {
+        switch (c) {
+            case 'i':
+                interval = (int)strtol(optarg, &end, 10);
+
+                if (*end != '\0' || interval < 1) {
+                    usage();
+                }
+
+                break;
+
+            case 'l':
+                listing = 1;
+                break;
+
+            case 'n':
+                instance = optarg;
+                break;
+
+            case '?':
+                usage();
+                break;
+
+            default:
+                assert(0);
+        }
+    }
+
+    if (argc != optind || (listing && (interval > 0 || instance != NULL))) {
+        usage();
+    }
+
+    if (listing) {
+        return list();
+    }
+
+    if (instance == NULL) {
+        instance = instanceDefault() != NULL ? instanceDefault() : "";
+    }
+
+    if (!instanceValid(instance)) {
+        usage();
+    }
+
+    instanceName(name, METRICS_NAME, instance);
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    struct stat st;
+
+    if (fd == -1 || fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct hangmanMetrics)) {
+        (void)fprintf(stderr, "%s: No server running\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    struct hangmanMetrics *metrics = (struct hangmanMetrics *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (metrics == MAP_FAILED || __atomic_load_n(&metrics->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC ||
+        metricsSize(metrics->workers) > (size_t)st.st_size) {
+        (void)fprintf(stderr, "%s: Invalid metrics segment\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    struct hangmanShardMetrics *total = (struct hangmanShardMetrics *)malloc(2 * sizeof(struct hangmanShardMetrics));
+
+    if (total == NULL) {
+        (void)fprintf(stderr, "%s: malloc\n", progname);
+        return EXIT_FAILURE;
+    }
+
+    collect(metrics, &total[0]);
+    print(&total[0], NULL, interval);
+
+    for (int i = 1; interval > 0; i++) {
+        (void)sleep((unsigned int)interval);
+        collect(metrics, &total[i % 2]);
+        print(&total[i % 2], &total[(i + 1) % 2], interval);
+    }
+
+    free(total);
+    (void)munmap(metrics, (size_t)st.st_size);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file hangman-timer.c
+ * @brief Hierarchical timer wheel of hangman-server
+ */
+#include <stdlib.h>
+
+#include "hangman-timer.h"
+
+#define WHEEL_SPAN ((1u << (WHEEL_BITS * WHEEL_LEVELS)) - 1) // Farthest tick a timer can be put at
+
+/**
+ * List head of the slot a timer belongs to
+ * @param  wheel   Wheel
+ * @param  expires Tick the timer fires at, not before the current tick
+ * @return         Index of the list head
+ */
+static uint32_t wheelHead(const struct hangmanWheel *wheel, uint32_t expires) {
+    uint32_t delta = expires - wheel->now;
+    unsigned int level = 0;
+
+    while (level < WHEEL_LEVELS - 1 && delta >= 1u << (WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+
+    return (uint32_t)wheel->capacity + level * WHEEL_SLOTS + ((expires >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+}
+
+/**
+ * Unlinks a scheduled timer
+ * @param wheel Wheel
+ * @param index Index of the timer
+ */
+static void wheelUnlink(struct hangmanWheel *wheel, uint32_t index) {
+    struct hangmanTimer *timer = &wheel->timers[index];
+
+    wheel->timers[timer->prev].next = timer->next;
+    wheel->timers[timer->next].prev = timer->prev;
+    timer->next = WHEEL_NONE;
+    timer->prev = WHEEL_NONE;
+}
+
+int wheelInit(struct hangmanWheel *wheel, size_t capacity, uint32_t now) {
+    size_t heads = WHEEL_LEVELS * WHEEL_SLOTS;
+
+    wheel->timers = (struct hangmanTimer *)calloc(capacity + heads, sizeof(struct hangmanTimer));
+    wheel->capacity = capacity;
+    wheel->now = now;
+
+    if (wheel->timers == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < capacity; i++) {
+        wheel->timers[i].next = WHEEL_NONE;
+        wheel->timers[i].prev = WHEEL_NONE;
+    }
+
+    // Empty circular lists
+    for (size_t i = capacity; i < capacity + heads; i++) {
+        wheel->timers[i].next = (uint32_t)i;
+        wheel->timers[i].prev = (uint32_t)i;
+    }
+
+    return 0;
+}
+
+/**
+ * Links an unscheduled timer into its slot
+ * @param wheel   Wheel
+ * @param index   Index of the timer
+ * @param expires Tick the timer fires at, not before the current tick
+ */
+static void wheelInsert(struct hangmanWheel *wheel, uint32_t index, uint32_t expires) {
+    struct hangmanTimer *timer = &wheel->timers[index];
+    uint32_t head = wheelHead(wheel, expires);
+
+    timer->expires = expires;
+    timer->prev = wheel->timers[head].prev;
+    timer->next = head;
+    wheel->timers[timer->prev].next = index;
+    wheel->timers[head].prev = index;
+}
+
+void wheelSchedule(struct hangmanWheel *wheel, uint32_t index, uint32_t expires) {
+    if (wheel->timers[index].next != WHEEL_NONE) {
+        wheelUnlink(wheel, index);
+    }
+
+    if ((int32_t)(expires - wheel->now) <= 0) {
+        expires = wheel->now + 1;
+    } else if (expires - wheel->now > WHEEL_SPAN) {
+        expires = wheel->now + WHEEL_SPAN;
+    }
+
+    wheelInsert(wheel, index, expires);
+}
+
+void wheelCancel(struct hangmanWheel *wheel, uint32_t index) {
+    if (wheel->timers[index].next != WHEEL_NONE) {
+        wheelUnlink(wheel, index);
+    }
+}
+
+void wheelAdvance(struct hangmanWheel *wheel, uint32_t now, void (*expire)(void *argument, uint32_t index), void *argument) {
+    while ((int32_t)(now - wheel->now) > 0) {
+        wheel->now++;
+
+        // Moves the timers of a higher level down once the levels below wrapped around
+        for (unsigned int level = 1; level < WHEEL_LEVELS; level++) {
+            if ((wheel->now & ((1u << (WHEEL_BITS * level)) - 1)) != 0) {
+                break;
+            }
+
+            uint32_t head = (uint32_t)wheel->capacity + level * WHEEL_SLOTS + ((wheel->now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+
+            while (wheel->timers[head].next != head) {
+                uint32_t index = wheel->timers[head].next;
+
+                // Timers due right now end up in the slot fired below
+                wheelUnlink(wheel, index);
+                wheelInsert(wheel, index, wheel->timers[index].expires);
+            }
+        }
+
+        uint32_t head = (uint32_t)wheel->capacity + (wheel->now & (WHEEL_SLOTS - 1));
+
+        while (wheel->timers[head].next != head) {
+            uint32_t index = wheel->timers[head].next;
+
+            wheelUnlink(wheel, index);
+            expire(argument, index);
+        }
+    }
+}
+
+void wheelFree(struct hangmanWheel *wheel) {
+    free(wheel->timers);
+    wheel->timers = NULL;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file hangman-timer.h
+ * @brief Hierarchical timer wheel of hangman-server with one timer per session record.
+ *        Scheduling and cancelling are O(1), a tick moves timers down one level at most
+ */
+#ifndef HANGMAN_TIMER_H
+#define HANGMAN_TIMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1u << WHEEL_BITS)
+#define WHEEL_LEVELS 4 // Covers 2^24 ticks, later timers fire early and are scheduled again
+#define WHEEL_NONE   UINT32_MAX
+
+/**
+ * Timer of one session record, also holds what the expiry needs to know about the session
+ */
+struct hangmanTimer {
+    uint32_t next; // Neighbours in the list of a wheel slot, WHEEL_NONE if not scheduled
+    uint32_t prev;
+    uint32_t expires; // Tick the timer fires at
+    uint32_t active; // Tick of the last request of the session
+    uint64_t started; // Start time of the client process, see processStarted, 0 until the first liveness check
+};
+
+struct hangmanWheel {
+    struct hangmanTimer *timers; // One per record, followed by the list heads of the slots
+    size_t capacity;
+    uint32_t now; // Current tick
+};
+
+/**
+ * Prepares a wheel without scheduled timers
+ * @param  wheel    Wheel to initialize
+ * @param  capacity Number of timers, indexed from 0
+ * @param  now      Current tick
+ * @return          0 on success, -1 if out of memory
+ */
+int wheelInit(struct hangmanWheel *wheel, size_t capacity, uint32_t now);
+
+/**
+ * Schedules a timer, a scheduled timer is moved
+ * @param wheel   Wheel
+ * @param index   Index of the timer
+ * @param expires Tick to fire at, fires at the next tick if it passed already
+ */
+void wheelSchedule(struct hangmanWheel *wheel, uint32_t index, uint32_t expires);
+
+/**
+ * Cancels a timer, nothing happens if it is not scheduled
+ * @param wheel Wheel
+ * @param index Index of the timer
+ */
+void wheelCancel(struct hangmanWheel *wheel, uint32_t index);
+
+/**
+ * Advances the wheel and fires the timers that expired on the way, a fired timer is no
+ * longer scheduled when the callback runs and may be scheduled again by it
+ * @param wheel    Wheel
+ * @param now      Current tick
+ * @param expire   Called for every fired timer
+ * @param argument Passed to expire
+ */
+void wheelAdvance(struct hangmanWheel *wheel, uint32_t now, void (*expire)(void *argument, uint32_t index), void *argument);
+
+/**
+ * Frees the timers
+ * @param wheel Wheel
+ */
+void wheelFree(struct hangmanWheel *wheel);
+
+#endif
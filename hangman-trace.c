@@ -0,0 +1,177 @@
+/**
+ * @file hangman-trace.c
+ * @brief Binary trace of the requests hangman-server handles
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hangman-ring.h"
+#include "hangman-trace.h"
+
+#define TRACE_RING     65536 // Power of two, about 5 MiB
+#define TRACE_BUFFER   (1 << 20) // Bytes buffered by stdio before a write
+#define TRACE_INTERVAL 10000000 // ns the background thread sleeps when the ring is empty
+
+struct hangmanTraceEntry {
+    struct hangmanTraceRecord record;
+    char letters[MAX_BATCH];
+};
+
+int traceActive = 0;
+
+static struct hangmanRing ring;
+static uint64_t origin; // CLOCK_MONOTONIC of the start in ns
+static uint64_t written;
+static int failed; // A write failed, the rest of the trace is discarded
+static FILE *output;
+static char *buffer;
+
+/**
+ * Monotonic time in nanoseconds
+ */
+static uint64_t now(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Writes a record and its letters
+ * @param ring The trace ring
+ * @param data Entry to write
+ */
+static void store(struct hangmanRing *ring, void *data) {
+    const struct hangmanTraceEntry *entry = (const struct hangmanTraceEntry *)data;
+
+    (void)ring;
+
+    if (!failed && (fwrite(&entry->record, sizeof(entry->record), 1, output) != 1 ||
+                    fwrite(entry->letters, 1, entry->record.batch, output) != entry->record.batch)) {
+        failed = 1;
+    }
+
+    written++;
+}
+
+/**
+ * Releases the file and the buffers of a trace that could not be started
+ */
+static void traceFree(void) {
+    if (output != NULL) {
+        (void)fclose(output);
+        output = NULL;
+    }
+
+    ringFree(&ring);
+    free(buffer);
+    buffer = NULL;
+}
+
+int traceStart(const char *path) {
+    struct hangmanTraceHeader header;
+    struct timespec realtime;
+
+    buffer = (char *)malloc(TRACE_BUFFER);
+    output = fopen(path, "wb");
+
+    if (ringInit(&ring, TRACE_RING, sizeof(struct hangmanTraceEntry), TRACE_INTERVAL, store, NULL) == -1 ||
+        buffer == NULL || output == NULL) {
+        traceFree();
+        return -1;
+    }
+
+    (void)setvbuf(output, buffer, _IOFBF, TRACE_BUFFER);
+
+    origin = now();
+    (void)clock_gettime(CLOCK_REALTIME, &realtime);
+
+    memset(&header, 0, sizeof(header));
+    (void)memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(struct hangmanTraceRecord);
+    header.started = (uint64_t)realtime.tv_sec * 1000000000u + (uint64_t)realtime.tv_nsec;
+
+    if (fwrite(&header, sizeof(header), 1, output) != 1) {
+        traceFree();
+        return -1;
+    }
+
+    if (ringStart(&ring) == -1) {
+        traceFree();
+        return -1;
+    }
+
+    traceActive = 1;
+
+    return 0;
+}
+
+int traceStop(uint64_t *records) {
+    *records = 0;
+
+    if (!traceActive) {
+        return -1;
+    }
+
+    traceActive = 0;
+    ringStop(&ring);
+
+    // The records are complete, the header gets the counts
+    if (!failed) {
+        uint64_t counts[2] = { written, __atomic_load_n(&ring.dropped, __ATOMIC_RELAXED) };
+
+        failed = fseek(output, (long)offsetof(struct hangmanTraceHeader, records), SEEK_SET) != 0 ||
+                 fwrite(counts, sizeof(counts), 1, output) != 1;
+    }
+
+    if (fclose(output) != 0) {
+        failed = 1;
+    }
+
+    output = NULL;
+    free(buffer);
+    buffer = NULL;
+
+    *records = written;
+
+    // Request threads may still be inside tracePush, the ring is released with the process
+    return failed ? -1 : 0;
+}
+
+void tracePush(const struct hangmanData *request, const struct hangmanData *state) {
+    unsigned int pos;
+    struct hangmanTraceEntry *entry = (struct hangmanTraceEntry *)ringReserve(&ring, &pos);
+
+    if (entry == NULL) {
+        return;
+    }
+
+    struct hangmanTraceRecord *record = &entry->record;
+    int batch = request->batch > 0 ? (request->batch < MAX_BATCH ? request->batch : MAX_BATCH) : 0;
+
+    memset(record, 0, sizeof(*record));
+    record->time = now() - origin;
+    record->player = request->player;
+    record->id = request->id;
+    record->signal = request->signal;
+    record->send = request->send;
+    record->batch = (uint8_t)batch;
+    record->band = (uint8_t)request->band;
+    record->format = (uint8_t)request->format;
+    record->status = -1;
+
+    if (state != NULL) {
+        record->index = state->index;
+        record->guessedMask = state->guessedMask;
+        record->status = state->status;
+        record->clientW = state->clientW;
+        record->clientL = state->clientL;
+        record->wrongGuesses = (uint8_t)state->wrongGuesses;
+    }
+
+    (void)memcpy(entry->letters, request->letters, (size_t)batch);
+    ringPublish(&ring, pos);
+}
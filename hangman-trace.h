@@ -0,0 +1,89 @@
+/**
+ * @file hangman-trace.h
+ * @brief Binary trace of the requests hangman-server handles, for hangman-replay. Like the log,
+ *        request threads put fixed-size records into a lock-free ring and a background thread
+ *        writes them through a large stdio buffer. A record the ring has no room for is counted
+ *        as dropped in the header instead of blocking the request
+ */
+#ifndef HANGMAN_TRACE_H
+#define HANGMAN_TRACE_H
+
+#include <stdint.h>
+
+#include "hangman-proto.h"
+
+#define TRACE_MAGIC   "HANGTRCE"
+#define TRACE_VERSION 1
+
+/**
+ * Header of a trace file, the records follow it
+ */
+struct hangmanTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(struct hangmanTraceRecord)
+    uint64_t started; // Unix time of the first record in ns
+    uint64_t records; // Records written, set when the trace is closed
+    uint64_t dropped; // Records lost to a full ring, set when the trace is closed
+};
+
+/**
+ * One request and the state it left the client in. Records of one client are in the order the
+ * server handled them, the batch letters of a request follow its record in the file
+ */
+struct hangmanTraceRecord {
+    uint64_t time; // ns since the trace started
+    uint64_t player; // playerKey, 0 for an anonymous client
+    int32_t id; // Client ID
+    int32_t index; // Word index after the request
+    uint32_t guessedMask; // Guessed letters after the request
+    int16_t signal;
+    int16_t status; // Status after the request, -1 if the client was removed or rejected
+    int16_t clientW;
+    int16_t clientL;
+    char send;
+    uint8_t batch; // Letters following the record
+    uint8_t band;
+    uint8_t format;
+    uint8_t wrongGuesses;
+    uint8_t reserved[3];
+};
+
+/**
+ * 1 while a trace is recorded
+ */
+extern int traceActive;
+
+/**
+ * Creates a trace file and starts the background thread
+ * @param  path Trace file, replaced if it exists
+ * @return      0 on success, -1 if the file can not be created or the thread not be started
+ */
+int traceStart(const char *path);
+
+/**
+ * Writes the remaining records, completes the header and stops the background thread
+ * @param  records Receives the number of records written
+ * @return         0 on success, -1 if no trace was recorded or it could not be written
+ */
+int traceStop(uint64_t *records);
+
+/**
+ * Queues a record, never blocks
+ * @param request Request of the client
+ * @param state   Session of the client after the request, NULL if the client was rejected
+ */
+void tracePush(const struct hangmanData *request, const struct hangmanData *state);
+
+/**
+ * Queues a record if a trace is recorded
+ * @param request Request of the client
+ * @param state   Session of the client after the request, NULL if the client was rejected
+ */
+static inline void traceWrite(const struct hangmanData *request, const struct hangmanData *state) {
+    if (traceActive) {
+        tracePush(request, state);
+    }
+}
+
+#endif
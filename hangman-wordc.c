@@ -0,0 +1,114 @@
+/**
+ * @file hangman-wordc.c
+ * @brief Compiles a word list into a binary dictionary that hangman-server maps at startup
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "hangman-select.h"
+#include "hangman-words.h"
+
+char *progname;
+
+struct hangmanWords words;
+struct hangmanIndex selection;
+void *stored; // The index as written to the dictionary
+
+/**
+ * Exits the programm and writes a usage description to stderr
+ */
+static void usage(void) {
+    (void)fprintf(stderr, "Usage: %s -o output-file [input-file]\n", progname);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Exits the programm freeing allocated space and printing an error message to stderr
+ * @param error Error description
+ */
+static void bail_out(char *error) {
+    (void)fprintf(stderr, "%s: %s\n", progname, error);
+    free(stored);
+    indexFree(&selection);
+    wordsFree(&words);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Main
+ * @brief     Main Function
+ * @param     argc Number of arguments
+ * @param     argv Array of arguments of type char*
+ * @result    int EXIT_SUCCESS or in case of an error EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    progname = argv[0];
+    char *output = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "o:")) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
+                break;
+
+            case '?':
+                usage();
+                break;
+
+            default:
+                assert(0);
+        }
+    }
+
+    if (output == NULL || argc - optind > 1) {
+        usage();
+    }
+
+    wordsInit(&words);
+
+    FILE *input = argc == optind ? stdin : fopen(argv[optind], "r");
+
+    if (input == NULL) {
+        bail_out("Could not read file");
+    }
+
+    if (wordsRead(&words, input) == -1) {
+        bail_out("Could not read words");
+    }
+
+    if (input != stdin) {
+        (void)fclose(input);
+    }
+
+    // The server maps the index instead of scoring and sorting the words on every start
+    if (indexBuild(&selection, &words) == -1 || (stored = malloc(indexStoredSize(&selection))) == NULL) {
+        bail_out("Could not build the index");
+    }
+
+    indexStore(&selection, stored);
+
+    FILE *file = fopen(output, "wb");
+
+    if (file == NULL) {
+        bail_out("Could not write file");
+    }
+
+    if (wordsWrite(&words, stored, indexStoredSize(&selection), file) == -1) {
+        (void)fclose(file);
+        bail_out("Could not write dictionary");
+    }
+
+    if (fclose(file) == EOF) {
+        bail_out("Could not write dictionary");
+    }
+
+    (void)printf("%zu words compiled to %s\n", words.count, output);
+
+    free(stored);
+    indexFree(&selection);
+    wordsFree(&words);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+/**
+ * @file hangman-words.c
+ * @brief Word store of hangman-server, block reader, arena management and compiled dictionaries
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hangman-words.h"
+
+#define READ_BLOCK (1 << 16)
+
+/**
+ * Rounds up to the alignment of a dictionary section
+ */
+static uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+void wordsInit(struct hangmanWords *words) {
+    memset(words, 0, sizeof(*words));
+}
+
+int wordsAdd(struct hangmanWords *words, const char *word, size_t length) {
+    if (words->arenaSize + length + 1 > words->arenaCapacity) {
+        size_t capacity = words->arenaCapacity == 0 ? READ_BLOCK : words->arenaCapacity * 2;
+        char *arena = (char *)realloc(words->arena, capacity);
+
+        if (arena == NULL) {
+            return -1;
+        }
+
+        words->arena = arena;
+        words->arenaCapacity = capacity;
+    }
+
+    if (words->count == words->capacity) {
+        size_t capacity = words->capacity == 0 ? 1024 : words->capacity * 2;
+        uint32_t *offset = (uint32_t *)realloc(words->offset, capacity * sizeof(uint32_t));
+
+        if (offset == NULL) {
+            return -1;
+        }
+
+        words->offset = offset;
+
+        uint32_t *mask = (uint32_t *)realloc(words->mask, capacity * sizeof(uint32_t));
+
+        if (mask == NULL) {
+            return -1;
+        }
+
+        words->mask = mask;
+
+        uint8_t *lengths = (uint8_t *)realloc(words->length, capacity * sizeof(uint8_t));
+
+        if (lengths == NULL) {
+            return -1;
+        }
+
+        words->length = lengths;
+
+        uint32_t *posStart = (uint32_t *)realloc(words->posStart, capacity * sizeof(uint32_t));
+
+        if (posStart == NULL) {
+            return -1;
+        }
+
+        words->posStart = posStart;
+        words->capacity = capacity;
+    }
+
+    if (words->positionCount + 26 > words->positionCapacity) {
+        size_t capacity = words->positionCapacity == 0 ? 4096 : words->positionCapacity * 2;
+        uint32_t *positions = (uint32_t *)realloc(words->positions, capacity * sizeof(uint32_t));
+
+        if (positions == NULL) {
+            return -1;
+        }
+
+        words->positions = positions;
+        words->positionCapacity = capacity;
+    }
+
+    char *dest = words->arena + words->arenaSize;
+    uint32_t positions[26]; // Only valid for letters in mask
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        int letter = (word[i] & ~0x20) - 'A';      // Letters only, clear the lowercase bit
+        uint32_t at = i < WORDS_POSITIONS ? 1u << i : 0;
+
+        dest[i] = (char)('A' + letter);
+        positions[letter] = (mask & (1u << letter)) ? positions[letter] | at : at;
+        mask |= 1u << letter;
+    }
+
+    dest[length] = '\0';
+
+    words->posStart[words->count] = (uint32_t)words->positionCount;
+
+    for (uint32_t rest = mask; rest != 0; rest &= rest - 1) {
+        words->positions[words->positionCount++] = positions[__builtin_ctz(rest)];
+    }
+
+    words->offset[words->count] = (uint32_t)words->arenaSize;
+    words->mask[words->count] = mask;
+    words->length[words->count] = (uint8_t)length;
+    words->count++;
+    words->arenaSize += length + 1;
+
+    return 0;
+}
+
+int wordsRead(struct hangmanWords *words, FILE *file) {
+    char *block = (char *)malloc(READ_BLOCK);
+    char line[MAX_WORD_LENGTH];
+    size_t i = 0;
+    size_t n;
+
+    if (block == NULL) {
+        return -1;
+    }
+
+    while ((n = fread(block, 1, READ_BLOCK, file)) > 0) {
+        for (size_t j = 0; j < n; j++) {
+            char c = block[j];
+
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+                if (i < MAX_WORD_LENGTH - 1) {
+                    line[i++] = c;
+                }
+            } else if (c == '\n' || c == ' ') {
+                if (i > 0 && wordsAdd(words, line, i) == -1) {
+                    free(block);
+                    return -1;
+                }
+
+                i = 0;
+            }
+        }
+    }
+
+    free(block);
+
+    if (ferror(file)) {
+        return -1;
+    }
+
+    return i > 0 ? wordsAdd(words, line, i) : 0;     // Last word without a trailing newline
+}
+
+int wordsIsCompiled(FILE *file) {
+    char magic[sizeof(((struct hangmanDictHeader *)0)->magic)];
+    long position = ftell(file);
+    int compiled = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, WORDS_MAGIC, sizeof(magic)) == 0;
+
+    (void)fseek(file, position, SEEK_SET);
+
+    return compiled;
+}
+
+int wordsWrite(const struct hangmanWords *words, const void *index, size_t indexSize, FILE *file) {
+    struct hangmanDictHeader header;
+    static const char zero[8];
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORDS_MAGIC, sizeof(header.magic));
+    header.version = WORDS_VERSION;
+    header.count = (uint32_t)words->count;
+    header.arenaSize = words->arenaSize;
+    header.offsetStart = align(sizeof(header));
+    header.maskStart = align(header.offsetStart + words->count * sizeof(uint32_t));
+    header.lengthStart = align(header.maskStart + words->count * sizeof(uint32_t));
+    header.arenaStart = align(header.lengthStart + words->count * sizeof(uint8_t));
+    header.positionCount = words->positionCount;
+    header.posStartStart = align(header.arenaStart + words->arenaSize);
+    header.positionsStart = align(header.posStartStart + words->count * sizeof(uint32_t));
+    header.indexSize = index != NULL ? indexSize : 0;
+    header.indexStart = align(header.positionsStart + words->positionCount * sizeof(uint32_t));
+
+    const struct {
+        const void *data;
+        uint64_t size;
+        uint64_t start;
+    } sections[] = {
+        { &header, sizeof(header), 0 },
+        { words->offset, words->count * sizeof(uint32_t), header.offsetStart },
+        { words->mask, words->count * sizeof(uint32_t), header.maskStart },
+        { words->length, words->count * sizeof(uint8_t), header.lengthStart },
+        { words->arena, words->arenaSize, header.arenaStart },
+        { words->posStart, words->count * sizeof(uint32_t), header.posStartStart },
+        { words->positions, words->positionCount * sizeof(uint32_t), header.positionsStart },
+        { index, header.indexSize, header.indexStart },
+    };
+    uint64_t position = 0;
+
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++) {
+        if (fwrite(zero, 1, sections[i].start - position, file) != sections[i].start - position) {
+            return -1;
+        }
+
+        if (sections[i].size > 0 && fwrite(sections[i].data, 1, sections[i].size, file) != sections[i].size) {
+            return -1;
+        }
+
+        position = sections[i].start + sections[i].size;
+    }
+
+    return fflush(file) == 0 ? 0 : -1;
+}
+
+/**
+ * Checks that a section lies within a file, without overflowing
+ * @param  start Offset of the section
+ * @param  count Number of elements
+ * @param  size  Size of an element
+ * @param  file  Size of the file
+ * @return       1 if it fits and is aligned, 0 otherwise
+ */
+static int sectionFits(uint64_t start, uint64_t count, uint64_t size, uint64_t file) {
+    return start % 8 == 0 && start <= file && count <= (file - start) / size;
+}
+
+int wordsMap(struct hangmanWords *words, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct hangmanDictHeader)) {
+        (void)close(fd);
+        return -1;
+    }
+
+    void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    const struct hangmanDictHeader *header = (const struct hangmanDictHeader *)mapping;
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t count = header->count;
+
+    if (memcmp(header->magic, WORDS_MAGIC, sizeof(header->magic)) != 0 || header->version != WORDS_VERSION ||
+        !sectionFits(header->offsetStart, count, sizeof(uint32_t), size) || !sectionFits(header->maskStart, count, sizeof(uint32_t), size) ||
+        !sectionFits(header->lengthStart, count, sizeof(uint8_t), size) || !sectionFits(header->arenaStart, header->arenaSize, 1, size) ||
+        !sectionFits(header->posStartStart, count, sizeof(uint32_t), size) ||
+        !sectionFits(header->positionsStart, header->positionCount, sizeof(uint32_t), size) ||
+        !sectionFits(header->indexStart, header->indexSize, 1, size)) {
+        (void)munmap(mapping, (size_t)st.st_size);
+        return -1;
+    }
+
+    char *base = (char *)mapping;
+
+    wordsInit(words);
+    words->arena = base + header->arenaStart;
+    words->arenaSize = header->arenaSize;
+    words->offset = (uint32_t *)(base + header->offsetStart);
+    words->mask = (uint32_t *)(base + header->maskStart);
+    words->length = (uint8_t *)(base + header->lengthStart);
+    words->posStart = (uint32_t *)(base + header->posStartStart);
+    words->count = count;
+    words->positions = (uint32_t *)(base + header->positionsStart);
+    words->positionCount = header->positionCount;
+    words->mapping = mapping;
+    words->mappingSize = (size_t)st.st_size;
+    words->index = header->indexSize > 0 ? base + header->indexStart : NULL;
+    words->indexSize = header->indexSize;
+
+    return 0;
+}
+
+size_t wordsMemory(const struct hangmanWords *words) {
+    if (words->mapping != NULL) {
+        return 0;
+    }
+
+    return words->arenaCapacity + words->capacity * (3 * sizeof(uint32_t) + sizeof(uint8_t)) +
+           words->positionCapacity * sizeof(uint32_t);
+}
+
+void wordsFree(struct hangmanWords *words) {
+    if (words->mapping != NULL) {
+        (void)munmap(words->mapping, words->mappingSize);
+    } else {
+        free(words->arena);
+        free(words->offset);
+        free(words->mask);
+        free(words->length);
+        free(words->posStart);
+        free(words->positions);
+    }
+
+    wordsInit(words);
+}
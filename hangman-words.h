@@ -0,0 +1,191 @@
+/**
+ * @file hangman-words.h
+ * @brief Word store of hangman-server, all words packed into one arena with an offset/length index.
+ *        The store is either built in memory from a word list or mapped read-only from a
+ *        dictionary compiled by hangman-wordc
+ */
+#ifndef HANGMAN_WORDS_H
+#define HANGMAN_WORDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hangman-proto.h"
+
+#define WORDS_MAGIC     "HANGDICT"
+#define WORDS_VERSION   3
+#define WORDS_POSITIONS 32 // Positions covered by the position bitmaps
+#define WORDS_LETTERS   0x3ffffffu // Mask of the letters A to Z
+
+/**
+ * Header of a compiled dictionary, section offsets are relative to the start of the file
+ * and aligned to 8 bytes
+ */
+struct hangmanDictHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t arenaSize;
+    uint64_t offsetStart; // uint32_t[count]
+    uint64_t maskStart; // uint32_t[count]
+    uint64_t lengthStart; // uint8_t[count]
+    uint64_t arenaStart; // char[arenaSize]
+    uint64_t positionCount;
+    uint64_t posStartStart; // uint32_t[count]
+    uint64_t positionsStart; // uint32_t[positionCount]
+    uint64_t indexSize;
+    uint64_t indexStart; // Selection index of hangman-select, none if indexSize is 0
+};
+
+struct hangmanWords {
+    char *arena; // Uppercase words, each terminated by '\0'
+    size_t arenaSize;
+    size_t arenaCapacity;
+
+    uint32_t *offset; // Start of each word in the arena
+    uint32_t *mask; // Bit n is set if the word contains letter 'A' + n
+    uint8_t *length;
+    uint32_t *posStart; // First position bitmap of each word
+    size_t count;
+    size_t capacity;
+
+    uint32_t *positions; // One bitmap per letter of a word in alphabetical order, bit n is position n
+    size_t positionCount;
+    size_t positionCapacity;
+
+    void *mapping; // Compiled dictionary if the store is mapped, NULL otherwise
+    size_t mappingSize;
+    const void *index; // Selection index stored in the compiled dictionary, NULL if there is none
+    size_t indexSize;
+};
+
+/**
+ * Prepares an empty word store
+ * @param words Word store to initialize
+ */
+void wordsInit(struct hangmanWords *words);
+
+/**
+ * Adds a word, converted to uppercase
+ * @param  words  Word store
+ * @param  word   Letters of the word, need not be terminated
+ * @param  length Number of letters, less than MAX_WORD_LENGTH
+ * @return        0 on success, -1 if out of memory
+ */
+int wordsAdd(struct hangmanWords *words, const char *word, size_t length);
+
+/**
+ * Reads a word list in large blocks, words are separated by newlines or spaces
+ * and characters other than letters are ignored
+ * @param  words Word store
+ * @param  file  The file to read
+ * @return       0 on success, -1 on a read error or if out of memory
+ */
+int wordsRead(struct hangmanWords *words, FILE *file);
+
+/**
+ * Checks whether a file is a compiled dictionary, the file position is restored
+ * @param  file File to check
+ * @return      1 if the file starts with WORDS_MAGIC, 0 otherwise
+ */
+int wordsIsCompiled(FILE *file);
+
+/**
+ * Writes the store as compiled dictionary
+ * @param  words     Word store
+ * @param  index     Selection index to store with the words, NULL for none
+ * @param  indexSize Size of the index in bytes
+ * @param  file      Destination
+ * @return           0 on success, -1 on a write error
+ */
+int wordsWrite(const struct hangmanWords *words, const void *index, size_t indexSize, FILE *file);
+
+/**
+ * Maps a compiled dictionary read-only, the pages are shared with every process mapping it.
+ * Only the header and the section bounds are checked, words are checked by wordValid on use
+ * @param  words Empty word store
+ * @param  path  Path of the compiled dictionary
+ * @return       0 on success, -1 if the file can not be mapped or is no valid dictionary
+ */
+int wordsMap(struct hangmanWords *words, const char *path);
+
+/**
+ * Number of bytes allocated by the word store
+ * @param  words Word store
+ * @return       Size of arena and index in bytes, 0 if the store is mapped
+ */
+size_t wordsMemory(const struct hangmanWords *words);
+
+/**
+ * Frees the word store
+ * @param words Word store
+ */
+void wordsFree(struct hangmanWords *words);
+
+/**
+ * Returns a word
+ * @param  words Word store
+ * @param  index Index of the word, less than words->count
+ * @return       The uppercase word
+ */
+static inline const char *wordAt(const struct hangmanWords *words, size_t index) {
+    return words->arena + words->offset[index];
+}
+
+/**
+ * Returns the positions of a letter in a word
+ * @param  words  Word store
+ * @param  index  Index of the word
+ * @param  letter Uppercase letter
+ * @return        Bit n is set if the letter is at position n, positions from WORDS_POSITIONS on are not covered
+ */
+static inline uint32_t wordPositions(const struct hangmanWords *words, size_t index, char letter) {
+    uint32_t mask = words->mask[index];
+    uint32_t bit = 1u << (letter - 'A');
+
+    if ((mask & bit) == 0) {
+        return 0;
+    }
+
+    return words->positions[words->posStart[index] + __builtin_popcount(mask & (bit - 1))];
+}
+
+/**
+ * Checks a word before it is used, a damaged or crafted dictionary must not make the server
+ * read outside its mapping. The word lies within the arena, is shorter than MAX_WORD_LENGTH,
+ * ends with '\0', has only letters A to Z matching its mask, and its position bitmaps lie
+ * within the position table. Words added in memory always pass
+ * @param  words Word store
+ * @param  index Index of the word, less than words->count
+ * @return       1 if the word can be used, 0 otherwise
+ */
+static inline int wordValid(const struct hangmanWords *words, size_t index) {
+    if (words->mapping == NULL) {
+        return 1;
+    }
+
+    uint64_t offset = words->offset[index];
+    size_t length = words->length[index];
+    uint32_t mask = 0;
+
+    if (length == 0 || length >= MAX_WORD_LENGTH || offset + length >= words->arenaSize ||
+        (words->mask[index] & ~WORDS_LETTERS) != 0 ||
+        (uint64_t)words->posStart[index] + (uint64_t)__builtin_popcount(words->mask[index]) > words->positionCount) {
+        return 0;
+    }
+
+    const char *word = words->arena + offset;
+
+    for (size_t i = 0; i < length; i++) {
+        if (word[i] < 'A' || word[i] > 'Z') {
+            return 0;
+        }
+
+        mask |= 1u << (word[i] - 'A');
+    }
+
+    return word[length] == '\0' && mask == words->mask[index];
+}
+
+#endif
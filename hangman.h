@@ -18,40 +18,17 @@
 #include <semaphore.h>
 #include <fcntl.h>
 
-#define SHM_NAME        "/hangmanData"
-#define SEM_SERVER      "/hangmanServer"
-#define SEM_CLIENT      "/hangmanClient"
-#define SEM_LOCKED      "/hangmanLOCKED"
+#include "hangman-proto.h"
 
-#define PERMISSION      (0600)
-#define MAX_WORD_LENGTH 128
-
-sem_t *server;
-sem_t *client;
-sem_t *locked;
+sem_t *client; // Doorbell, posted once for every request pushed to the ring
+sem_t *locked; // Admission, counts the free slots
 
 char *progname;
 
-struct hangmanData {
-    // Server
-    short status; // 0(not ingame), 1(not ingame, wrong input), 2(ingame), 3(ingame, wrong input), -1(disconnect client), -2(server shutdown)
-    char info[128];
-
-    short wrongGuesses;
-    int index;
-    char word[MAX_WORD_LENGTH];
-    char guessed[26];
-
-    short clientW;
-    short clientL;
-    // Client
-    int id;
-    char send;
-    short signal;
-};
+struct hangmanShm *shm;
 
 /**
- * Shared object between server and client
+ * Shared object between server and client (data of the current slot)
  */
 struct hangmanData *shared;
 